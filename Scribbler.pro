@@ -4,7 +4,7 @@
 #
 #-------------------------------------------------
 
-QT       += core gui svg printsupport xml
+QT       += core gui svg printsupport concurrent
 
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 
@@ -18,14 +18,42 @@ SOURCES += main.cpp\
     preferencesdialog.cpp \
     fontdialog.cpp \
     symboldata.cpp \
-    symboldataeditor.cpp
+    symboldataeditor.cpp \
+    missingglyphs.cpp \
+    sheetitem.cpp \
+    svgpathparser.cpp \
+    glyphatlas.cpp \
+    glyphrastercache.cpp \
+    mipmapbuilder.cpp \
+    wordcache.cpp \
+    sheetdisplaylist.cpp \
+    sheetlayout.cpp \
+    renderworker.cpp \
+    fontcache.cpp \
+    glyphpack.cpp \
+    svgrestyler.cpp
 
 HEADERS  += mainwindow.h \
     svgview.h \
     preferencesdialog.h \
     fontdialog.h \
     symboldata.h \
-    symboldataeditor.h
+    symboldataeditor.h \
+    missingglyphs.h \
+    svgdata.h \
+    sheetitem.h \
+    renderstatistics.h \
+    svgpathparser.h \
+    glyphatlas.h \
+    glyphrastercache.h \
+    mipmapbuilder.h \
+    wordcache.h \
+    sheetdisplaylist.h \
+    sheetlayout.h \
+    renderworker.h \
+    fontcache.h \
+    glyphpack.h \
+    svgrestyler.h
 
 FORMS    += mainwindow.ui \
     preferencesdialog.ui \
@@ -0,0 +1,135 @@
+#include "fontcache.h"
+
+#include <QtCore/QDataStream>
+#include <QtCore/QCryptographicHash>
+#include <QtCore/QDateTime>
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QSaveFile>
+#include <QtCore/QStandardPaths>
+
+namespace
+{
+const quint32 fontMagic = 0x53464331; //"SFC1"
+const quint32 formatVersion = 4;      //!< increase it when prepareSymbol() computes SvgData in other way
+const int keptFonts = 8;
+}
+
+FontCache::FontCache(const QString &directory)
+{
+    cacheDirectory = directory.isEmpty()
+            ? QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/fonts"
+            : directory;
+}
+
+QByteArray FontCache::fontKey(const QString &fontPath, const QStringList &svgFiles, const QByteArray &parameters)
+{
+    QByteArray stamps;
+    QDataStream stream(&stamps, QIODevice::WriteOnly);
+    QFileInfo fontInfo(fontPath);
+    stream << formatVersion << fontInfo.absoluteFilePath()
+           << fontInfo.lastModified().toMSecsSinceEpoch() << fontInfo.size();
+
+    for (const QString &fileName : svgFiles)
+    {
+        QFileInfo info(fileName);
+        stream << fileName << info.lastModified().toMSecsSinceEpoch() << info.size();
+    }
+
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(stamps);
+    hash.addData(parameters);
+    return hash.result();
+}
+
+bool FontCache::read(const QByteArray &key, QVector<Glyph> &glyphs) const
+{
+    QFile file(filePath(key));
+
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_5_0);
+    quint32 magic, count;
+    QByteArray storedKey;
+    in >> magic >> storedKey >> count;
+
+    if (magic != fontMagic || storedKey != key || in.status() != QDataStream::Ok)
+        return false;
+
+    glyphs.clear();
+    glyphs.reserve(count);
+
+    for (quint32 i = 0; i < count; i++)
+    {
+        Glyph glyph;
+        glyph.data.reset(new SvgData);
+        SvgData *data = glyph.data.data();
+        qint32 cap, join;
+        in >> glyph.key >> glyph.svg >> data->symbolData >> data->scale >> data->size
+           >> data->inPoint >> data->outPoint >> data->inTangent >> data->outTangent
+           >> data->sourceKey >> data->strokes >> data->strokeColor >> cap >> join >> data->lodPaths;
+
+        if (in.status() != QDataStream::Ok) //the file is broken, it will be rewritten
+        {
+            glyphs.clear();
+            return false;
+        }
+
+        data->strokeCap = Qt::PenCapStyle(cap);
+        data->strokeJoin = Qt::PenJoinStyle(join);
+
+        //only images that aren't strokes of one colour have a renderer, it's restyled later
+        if (!glyph.svg.isEmpty())
+        {
+            data->svg = glyph.svg;
+            data->renderer.reset(new QSvgRenderer(glyph.svg));
+        }
+
+        glyphs.push_back(glyph);
+    }
+
+    return true;
+}
+
+void FontCache::write(const QByteArray &key, const QVector<Glyph> &glyphs) const
+{
+    if (!QDir().mkpath(cacheDirectory))
+        return;
+
+    QSaveFile file(filePath(key)); //other threads can read the previous version meanwhile
+
+    if (!file.open(QIODevice::WriteOnly))
+        return;
+
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_5_0);
+    out << fontMagic << key << quint32(glyphs.size());
+
+    for (const Glyph &glyph : glyphs)
+    {
+        const SvgData *data = glyph.data.data();
+        out << glyph.key << glyph.svg << data->symbolData << data->scale << data->size
+            << data->inPoint << data->outPoint << data->inTangent << data->outTangent
+            << data->sourceKey << data->strokes << data->strokeColor
+            << qint32(data->strokeCap) << qint32(data->strokeJoin) << data->lodPaths;
+    }
+
+    if (file.commit())
+        removeOldFonts();
+}
+
+QString FontCache::filePath(const QByteArray &key) const
+{
+    return cacheDirectory + '/' + QString::fromLatin1(key.toHex());
+}
+
+void FontCache::removeOldFonts() const
+{
+    QFileInfoList files = QDir(cacheDirectory).entryInfoList(QDir::Files, QDir::Time);
+
+    for (int i = keptFonts; i < files.size(); i++)
+        QFile::remove(files.at(i).absoluteFilePath());
+}
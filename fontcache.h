@@ -0,0 +1,53 @@
+/*!
+    FontCache - compiled fonts stored on disk between runs.
+
+    SheetLayout::prepareSymbol() parses every SVG of a font and computes
+    metrics and strokes of the glyph. A compiled font keeps the results:
+    strokes in coordinates of the sheet, SVG bytes with the scaled viewBox
+    that go straight to QSvgRenderer for glyphs that aren't plain strokes,
+    and everything else of SvgData, so the next load doesn't open the SVG
+    files at all. The pen isn't compiled in, see SheetLayout::restyle().
+
+    The key of a compiled font is a hash of the INI path and time stamps
+    and sizes of the INI and all its SVG files, plus the settings that
+    change the geometry of glyphs (dpi and font size).
+    A changed file or setting never hits an old entry. Only a few recently
+    written fonts are kept.
+*/
+#ifndef FONTCACHE_H
+#define FONTCACHE_H
+
+#include <QtCore/QByteArray>
+#include <QtCore/QSharedPointer>
+#include <QtCore/QString>
+#include <QtCore/QStringList>
+#include <QtCore/QVector>
+
+#include "svgdata.h"
+
+class FontCache
+{
+public:
+    struct Glyph
+    {
+        QChar key;
+        QByteArray svg; //!< the SVG before restyling; empty if the glyph is drawn from its strokes
+        QSharedPointer<SvgData> data;
+    };
+
+    explicit FontCache(const QString &directory = QString());
+
+    //! svgFiles are all files the font refers to, parameters are settings that change glyphs
+    static QByteArray fontKey(const QString &fontPath, const QStringList &svgFiles, const QByteArray &parameters);
+
+    bool read(const QByteArray &key, QVector<Glyph> &glyphs) const; //!< creates renderers of glyphs that need them
+    void write(const QByteArray &key, const QVector<Glyph> &glyphs) const;
+
+private:
+    QString cacheDirectory;
+
+    QString filePath(const QByteArray &key) const;
+    void removeOldFonts() const;
+};
+
+#endif // FONTCACHE_H
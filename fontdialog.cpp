@@ -93,6 +93,8 @@ void FontDialog::loadFont()
     QString newFileName = QFileDialog::getSaveFileName(0, tr("Choose"), "",
                                                           tr("INI") +
                                                           "(*.ini);;" +
+                                                          tr("Glyph Pack") +
+                                                          "(*.sgp);;" +
                                                           tr("All Files") +
                                                           "(*.*)",
                                                        0, QFileDialog::DontConfirmOverwrite);
@@ -105,37 +107,57 @@ void FontDialog::loadFont()
     ui->fontFileTextEdit->setText(fontFileName);
     ui->autoLoadPushButton->setEnabled(true);
 
-    QSettings fontSettings(fontFileName, QSettings::IniFormat);
-    fontSettings.beginGroup("Font");
-    fontSettings.setIniCodec(QTextCodec::codecForName("UTF-8"));
-
-    if (fontSettings.allKeys().size() == 0)
+    if (GlyphPack::isGlyphPack(fontFileName))
     {
-        fontSettings.endGroup();
-        return;
+        if (!glyphPack.open(fontFileName))
+        {
+            showError();
+            return;
+        }
+
+        font.clear();
+        for (int i = 0; i < glyphPack.variantCount(); i++)
+        {
+            GlyphPack::Variant variant = glyphPack.variant(i);
+            font.insert(variant.symbol, variant.symbolData);
+        }
     }
+    else
+    {
+        glyphPack.close();
 
-    font.clear();
-    for (const QString &key : fontSettings.childKeys())
-        for (const SymbolData &value : fontSettings.value(key).value<QList<SymbolData>>())
+        QSettings fontSettings(fontFileName, QSettings::IniFormat);
+        fontSettings.beginGroup("Font");
+        fontSettings.setIniCodec(QTextCodec::codecForName("UTF-8"));
+
+        if (fontSettings.allKeys().size() == 0)
         {
-            if (key == "slash")
-                font.insert('/', value);
-            else if (key == "backslash")
-                font.insert('\\', value);
-            else
-                font.insert(key.at(0).toLower(), value);
+            fontSettings.endGroup();
+            return;
         }
 
-    //It's a dirty hack, which helps to distinguish uppercase and lowercase
-    //letters on a freaking case-insensetive Windows
-    fontSettings.beginGroup("UpperCase");
-    for (const QString &key : fontSettings.childKeys())
-        for (const SymbolData &value : fontSettings.value(key).value<QList<SymbolData>>())
-            font.insert(key.at(0).toUpper(), value);
-    fontSettings.endGroup();
+        font.clear();
+        for (const QString &key : fontSettings.childKeys())
+            for (const SymbolData &value : fontSettings.value(key).value<QList<SymbolData>>())
+            {
+                if (key == "slash")
+                    font.insert('/', value);
+                else if (key == "backslash")
+                    font.insert('\\', value);
+                else
+                    font.insert(key.at(0).toLower(), value);
+            }
 
-    fontSettings.endGroup();
+        //It's a dirty hack, which helps to distinguish uppercase and lowercase
+        //letters on a freaking case-insensetive Windows
+        fontSettings.beginGroup("UpperCase");
+        for (const QString &key : fontSettings.childKeys())
+            for (const SymbolData &value : fontSettings.value(key).value<QList<SymbolData>>())
+                font.insert(key.at(0).toUpper(), value);
+        fontSettings.endGroup();
+
+        fontSettings.endGroup();
+    }
 
     ui->treeWidget->clear();
 
@@ -195,6 +217,19 @@ void FontDialog::saveFont()
     if (fontFileName.isEmpty())
         return;
 
+    if (isGlyphPackFont())
+    {
+        loadFromEditorToFont();
+
+        bool isSaved = saveGlyphPack();
+        emit fontReady(); //the pack was released by every layout, so it's loaded again even if it isn't changed
+
+        if (!isSaved)
+            showError();
+
+        return;
+    }
+
     QFile file (fontFileName);
     file.remove();
 
@@ -235,10 +270,54 @@ void FontDialog::saveFont()
     emit fontReady();
 }
 
+bool FontDialog::isGlyphPackFont() const
+{
+    return glyphPack.isOpen() || QFileInfo(fontFileName).suffix().toLower() == "sgp";
+}
+
+bool FontDialog::saveGlyphPack()
+{
+    QString fontDirectory = QFileInfo(fontFileName).path() + '/';
+    QVector<GlyphPack::Variant> variants;
+
+    for (auto i = font.constBegin(); i != font.constEnd(); ++i)
+    {
+        QByteArray svg;
+        int packIndex = glyphPack.findFile(i.value().fileName);
+
+        if (packIndex >= 0)
+        {
+            //a deep copy, the pack is unmapped before it's written
+            svg = glyphPack.variant(packIndex).svg;
+            svg.detach();
+        }
+        else
+        {
+            QFile file(fontDirectory + i.value().fileName);
+
+            if (!file.open(QIODevice::ReadOnly))
+                return false;
+
+            svg = file.readAll();
+        }
+
+        variants.push_back({i.key(), i.value(), svg});
+    }
+
+    //on Windows the pack can't be replaced while it's mapped anywhere
+    emit glyphPackWriting(fontFileName);
+    glyphPack.close();
+    bool isWritten = GlyphPack::write(fontFileName, variants);
+    glyphPack.open(fontFileName);
+
+    return isWritten;
+}
+
 void FontDialog::rejectChanges()
 {
     font.clear();
     fontFileName.clear();
+    glyphPack.close();
     ui->SymbolFilesPushButton->setEnabled(false);
     ui->autoLoadPushButton->setEnabled(false);
     ui->choosenSymbolTextEdit->clear();
@@ -278,8 +357,9 @@ void FontDialog::setTextFromItem(QTreeWidgetItem *item)
     else
     {
         QString fileName = QFileInfo(fontFileName).path() + '/' + item->text(0);
+        int packIndex = glyphPack.findFile(item->text(0));
 
-        if (!QFileInfo(fileName).isReadable())
+        if (packIndex < 0 && !QFileInfo(fileName).isReadable())
         {
             resetSymbolDataEditor();
             showError();
@@ -288,7 +368,11 @@ void FontDialog::setTextFromItem(QTreeWidgetItem *item)
 
         enableDrawButtons(true, item->parent()->text(0).at(0).isLetter());
         ui->choosenSymbolTextEdit->setText(item->parent()->text(0));
-        ui->symbolDataEditor->load(fileName);
+
+        if (packIndex >= 0)
+            ui->symbolDataEditor->loadData(glyphPack.variant(packIndex).svg);
+        else
+            ui->symbolDataEditor->load(fileName);
         QList<SymbolData> dataList = font.values(item->parent()->text(0).at(0));
 
         for (const SymbolData &data : dataList)
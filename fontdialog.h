@@ -11,6 +11,9 @@
     equal to the width of the character. InPoint and outPoint are
     the points of entry and exit of connecting lines for the letter.
 
+    The same font can be a single glyph pack file (see GlyphPack),
+    which holds the images too.
+
     Font Editor allows the user to:
       * Create a new font and open an existing one for editing;
       * Upload an image to the font or remove it;
@@ -35,6 +38,7 @@
 #include <QtWidgets/QMessageBox>
 
 #include "symboldata.h"
+#include "glyphpack.h"
 
 namespace Ui {
 class FontDialog;
@@ -50,6 +54,7 @@ public:
 
 signals:
     void fontReady();
+    void glyphPackWriting(const QString &fileName); //!< every mapping of the pack must be closed before it's replaced
 
 private:
     enum ContextAction : int {
@@ -65,6 +70,10 @@ private:
 
     QString fontFileName;
     QMultiMap<QChar, SymbolData> font;
+    GlyphPack glyphPack; //!< images of the opened font if it's a glyph pack
+
+    bool isGlyphPackFont() const;
+    bool saveGlyphPack(); //!< writes images of the pack and added files to fontFileName
 
 private slots:
     void loadFont();
@@ -0,0 +1,153 @@
+#include "glyphatlas.h"
+
+#include <QtCore/QCryptographicHash>
+#include <QtCore/QDataStream>
+#include <QtCore/QtMath>
+
+GlyphAtlas::GlyphAtlas(int subpixelSteps, int pageSide)
+{
+    steps = qMax(1, subpixelSteps);
+    pageSize = pageSide;
+    rasterCache = nullptr;
+    shelfHeight = 0;
+}
+
+void GlyphAtlas::clear()
+{
+    cells.clear();
+    variants.clear();
+    pens.clear();
+    pages.clear();
+    shelfCursor = QPoint(0, 0);
+    shelfHeight = 0;
+}
+
+void GlyphAtlas::draw(QPainter *painter, const PlacedGlyph &glyph, const QPen &pen)
+{
+    const QTransform &transform = painter->transform();
+
+    //copying pixels is only correct if the sheet isn't scaled or rotated
+    if (transform.type() > QTransform::TxTranslate)
+    {
+        glyph.svgData->draw(painter, glyph.rect(), pen);
+        return;
+    }
+
+    //choose the bucket in device coordinates, where pixels are
+    QPointF devicePos = transform.map(glyph.pos);
+    QPoint origin(qFloor(devicePos.x()), qFloor(devicePos.y()));
+    int bucketX = qRound((devicePos.x() - origin.x()) * steps);
+    int bucketY = qRound((devicePos.y() - origin.y()) * steps);
+
+    if (bucketX == steps)
+    {
+        origin.rx()++;
+        bucketX = 0;
+    }
+
+    if (bucketY == steps)
+    {
+        origin.ry()++;
+        bucketY = 0;
+    }
+
+    int penIndex = pens.indexOf(pen);
+
+    if (penIndex < 0)
+    {
+        penIndex = pens.size();
+        pens.push_back(pen);
+    }
+
+    CellKey key(glyph.svgData.data(), qMakePair(penIndex, bucketY * steps + bucketX));
+    QHash<CellKey, Cell>::const_iterator i = cells.constFind(key);
+
+    if (i == cells.constEnd())
+        i = cells.insert(key, createCell(glyph.svgData, QPointF(bucketX, bucketY) / steps, pen));
+
+    if (i->page < 0)
+    {
+        glyph.svgData->draw(painter, glyph.rect(), pen);
+        return;
+    }
+
+    painter->drawImage(QPointF(origin) - QPointF(transform.dx(), transform.dy()),
+                       pages.at(i->page), i->rect);
+}
+
+GlyphAtlas::Cell GlyphAtlas::createCell(const QSharedPointer<SvgData> &data, const QPointF &offset, const QPen &pen)
+{
+    Cell cell = {-1, QRect()};
+    QSize size(qCeil(data->size.width()) + 1, qCeil(data->size.height()) + 1);
+
+    if (!allocate(size, cell))
+        return cell;
+
+    variants.insert(data.data(), data);
+
+    QByteArray key;
+    QImage image;
+
+    if (rasterCache != nullptr && !data->rasterKey.isEmpty())
+    {
+        //rasterKey has the pen of settings, but a sheet can be drawn with another one
+        QByteArray penData;
+        QDataStream stream(&penData, QIODevice::WriteOnly);
+        stream << pen;
+
+        key = QCryptographicHash::hash(data->rasterKey + penData, QCryptographicHash::Sha1) +
+              QByteArray::number(offset.x()) + ',' + QByteArray::number(offset.y());
+        image = rasterCache->find(key);
+    }
+
+    if (image.size() != size)
+    {
+        image = QImage(size, QImage::Format_ARGB32_Premultiplied);
+        image.fill(Qt::transparent);
+
+        QPainter imagePainter(&image);
+        imagePainter.setRenderHint(QPainter::Antialiasing);
+        data->draw(&imagePainter, QRectF(offset, data->size), pen);
+        imagePainter.end();
+
+        if (!key.isEmpty())
+            rasterCache->insert(key, image);
+    }
+
+    QPainter painter(&pages[cell.page]);
+    painter.setCompositionMode(QPainter::CompositionMode_Source);
+    painter.drawImage(cell.rect.topLeft(), image);
+
+    return cell;
+}
+
+bool GlyphAtlas::allocate(const QSize &size, Cell &cell)
+{
+    const int padding = 1; //keeps antialiased edges of neighbours apart
+
+    if (size.width() > pageSize || size.height() > pageSize)
+        return false;
+
+    //cells are placed on shelves, a new shelf starts when the current one is full
+    if (shelfCursor.x() + size.width() > pageSize)
+    {
+        shelfCursor = QPoint(0, shelfCursor.y() + shelfHeight + padding);
+        shelfHeight = 0;
+    }
+
+    if (pages.isEmpty() || shelfCursor.y() + size.height() > pageSize)
+    {
+        QImage page(pageSize, pageSize, QImage::Format_ARGB32_Premultiplied);
+        page.fill(Qt::transparent);
+        pages.push_back(page);
+        shelfCursor = QPoint(0, 0);
+        shelfHeight = 0;
+    }
+
+    cell.page = pages.size() - 1;
+    cell.rect = QRect(shelfCursor, size);
+    shelfCursor.rx() += size.width() + padding;
+    shelfHeight = qMax(shelfHeight, size.height());
+
+    return true;
+}
@@ -0,0 +1,65 @@
+/*!
+    GlyphAtlas - glyphs of the font rasterized once at the output
+    resolution and packed into a few large images.
+
+    Scene coordinates of SvgView are already pixels of the exported
+    image, so a glyph can be copied from the atlas instead of being
+    rendered by QSvgRenderer again. Positions of glyphs on a sheet are
+    fractional, so every variant is rasterized for a few subpixel
+    offsets (buckets) and the nearest one is used.
+
+    Cells are created on demand while sheets are exported and live until
+    clear() is called, which SvgView does when the font or the pen is
+    changed. The pen is a part of the key of a cell, so sheets drawn with
+    different pens never share cells.
+    If a GlyphRasterCache is set, cells are taken from it and stored
+    in it, so they are rasterized only once across runs.
+*/
+#ifndef GLYPHATLAS_H
+#define GLYPHATLAS_H
+
+#include <QtCore/QHash>
+#include <QtCore/QPair>
+#include <QtCore/QVector>
+#include <QtGui/QImage>
+#include <QtGui/QPainter>
+
+#include "sheetdisplaylist.h"
+#include "glyphrastercache.h"
+
+class GlyphAtlas
+{
+public:
+    explicit GlyphAtlas(int subpixelSteps = 4, int pageSide = 2048);
+
+    void draw(QPainter *painter, const PlacedGlyph &glyph, const QPen &pen); //!< draws the glyph like SvgData::draw() does
+    void clear();
+    void setRasterCache(GlyphRasterCache *cache) {rasterCache = cache;}
+
+    int cellCount() const {return cells.size();}
+    int pageCount() const {return pages.size();}
+
+private:
+    struct Cell
+    {
+        int page;   //!< -1 if the glyph doesn't fit a page and is rendered directly
+        QRect rect; //!< area of the cell on the page
+    };
+
+    typedef QPair<const SvgData *, QPair<int, int>> CellKey; //!< variant, index in pens and subpixel bucket
+
+    GlyphRasterCache *rasterCache;
+    int steps;
+    int pageSize;
+    QHash<CellKey, Cell> cells;
+    QHash<const SvgData *, QSharedPointer<SvgData>> variants; //!< keeps keys of cells valid
+    QVector<QPen> pens; //!< pens cells were drawn with
+    QVector<QImage> pages;
+    QPoint shelfCursor;
+    int shelfHeight;
+
+    Cell createCell(const QSharedPointer<SvgData> &data, const QPointF &offset, const QPen &pen);
+    bool allocate(const QSize &size, Cell &cell);
+};
+
+#endif // GLYPHATLAS_H
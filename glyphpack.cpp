@@ -0,0 +1,381 @@
+#include "glyphpack.h"
+#include "svgrestyler.h"
+
+#include <QtCore/QFileInfo>
+#include <QtCore/QSaveFile>
+#include <QtCore/QSettings>
+#include <QtCore/QTextCodec>
+#include <algorithm>
+
+namespace
+{
+const char packMagic[4] = {'S', 'G', 'P', '1'};
+const quint32 packVersion = 2;
+const quint32 hasPathFlag = 1;
+}
+
+struct GlyphPack::Header
+{
+    char magic[4];
+    quint32 version;
+    quint32 symbolCount;
+    quint32 variantCount;
+    quint32 symbolsOffset;  //!< SymbolEntry array
+    quint32 variantsOffset; //!< VariantRecord array
+    quint32 dataOffset;
+    quint32 dataSize;
+};
+
+struct GlyphPack::SymbolEntry
+{
+    quint32 code; //!< UTF-16 code unit
+    quint32 firstVariant;
+    quint32 variantCount;
+};
+
+struct GlyphPack::VariantRecord
+{
+    double inPoint[2];
+    double outPoint[2];
+    double limits[4];     //!< x, y, width, height
+    quint32 symbolIndex;
+    quint32 nameOffset;   //!< UTF-8, offsets are relative to Header::dataOffset
+    quint32 nameSize;
+    quint32 svgOffset;
+    quint32 svgSize;
+    quint32 pathOffset;   //!< PathElement array
+    quint32 pathSize;     //!< number of elements
+    quint32 flags;
+};
+
+struct GlyphPack::PathElement
+{
+    float x, y;
+    quint32 type; //!< QPainterPath::ElementType
+};
+
+GlyphPack::GlyphPack()
+{
+    data = nullptr;
+    size = 0;
+    header = nullptr;
+}
+
+GlyphPack::~GlyphPack()
+{
+    close();
+}
+
+bool GlyphPack::isGlyphPack(const QString &fileName)
+{
+    QFile file(fileName);
+
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+
+    char magic[4];
+    return file.read(magic, 4) == 4 && std::equal(magic, magic + 4, packMagic);
+}
+
+bool GlyphPack::open(const QString &fileName)
+{
+    close();
+
+    //records are used as they are, so the pack is readable on little-endian machines only
+    if (QSysInfo::ByteOrder != QSysInfo::LittleEndian)
+        return false;
+
+    file.setFileName(fileName);
+
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+
+    size = file.size();
+    data = size >= qint64(sizeof(Header)) ? file.map(0, size) : nullptr;
+
+    if (data == nullptr)
+    {
+        close();
+        return false;
+    }
+
+    const Header *candidate = reinterpret_cast<const Header *>(data);
+    header = candidate;
+
+    bool isValid = std::equal(candidate->magic, candidate->magic + 4, packMagic) &&
+                   candidate->version == packVersion &&
+                   isRangeValid(candidate->symbolsOffset, quint64(candidate->symbolCount) * sizeof(SymbolEntry)) &&
+                   isRangeValid(candidate->variantsOffset, quint64(candidate->variantCount) * sizeof(VariantRecord),
+                                alignof(VariantRecord)) &&
+                   isRangeValid(candidate->dataOffset, candidate->dataSize);
+
+    if (!isValid)
+    {
+        close();
+        return false;
+    }
+
+    return true;
+}
+
+void GlyphPack::close()
+{
+    if (data != nullptr)
+        file.unmap(const_cast<uchar *>(data));
+
+    file.close();
+    data = nullptr;
+    size = 0;
+    header = nullptr;
+}
+
+int GlyphPack::variantCount() const
+{
+    return isOpen() ? header->variantCount : 0;
+}
+
+GlyphPack::Variant GlyphPack::variant(int index) const
+{
+    Variant variant;
+    const VariantRecord *variantRecord = record(index);
+
+    if (variantRecord == nullptr)
+        return variant;
+
+    const SymbolEntry *symbols = reinterpret_cast<const SymbolEntry *>(data + header->symbolsOffset);
+    const char *blob = reinterpret_cast<const char *>(data + header->dataOffset);
+
+    if (variantRecord->symbolIndex < header->symbolCount)
+        variant.symbol = QChar(ushort(symbols[variantRecord->symbolIndex].code));
+
+    variant.symbolData.fileName = QString::fromUtf8(blob + variantRecord->nameOffset, variantRecord->nameSize);
+    variant.symbolData.inPoint = QPointF(variantRecord->inPoint[0], variantRecord->inPoint[1]);
+    variant.symbolData.outPoint = QPointF(variantRecord->outPoint[0], variantRecord->outPoint[1]);
+    variant.symbolData.limits = QRectF(variantRecord->limits[0], variantRecord->limits[1],
+                                       variantRecord->limits[2], variantRecord->limits[3]);
+    variant.svg = QByteArray::fromRawData(blob + variantRecord->svgOffset, variantRecord->svgSize);
+
+    return variant;
+}
+
+bool GlyphPack::variantPath(int index, QPainterPath &path) const
+{
+    const VariantRecord *variantRecord = record(index);
+
+    if (variantRecord == nullptr || !(variantRecord->flags & hasPathFlag))
+        return false;
+
+    const PathElement *elements = reinterpret_cast<const PathElement *>(data + header->dataOffset +
+                                                                         variantRecord->pathOffset);
+    path = QPainterPath();
+
+    for (quint32 i = 0; i < variantRecord->pathSize; i++)
+    {
+        const PathElement &element = elements[i];
+
+        switch (element.type)
+        {
+        case QPainterPath::MoveToElement:
+            path.moveTo(element.x, element.y);
+            break;
+        case QPainterPath::LineToElement:
+            path.lineTo(element.x, element.y);
+            break;
+        case QPainterPath::CurveToElement:
+            if (i + 2 >= variantRecord->pathSize)
+                return false;
+
+            path.cubicTo(element.x, element.y, elements[i + 1].x, elements[i + 1].y,
+                         elements[i + 2].x, elements[i + 2].y);
+            i += 2;
+            break;
+        default:
+            return false;
+        }
+    }
+
+    return true;
+}
+
+int GlyphPack::findFile(const QString &fileName) const
+{
+    for (int i = 0; i < variantCount(); i++)
+        if (variant(i).symbolData.fileName == fileName)
+            return i;
+
+    return -1;
+}
+
+const GlyphPack::VariantRecord * GlyphPack::record(int index) const
+{
+    if (!isOpen() || index < 0 || quint32(index) >= header->variantCount)
+        return nullptr;
+
+    const VariantRecord *variantRecord = reinterpret_cast<const VariantRecord *>(data + header->variantsOffset) + index;
+
+    //a broken record must not point outside of the file
+    quint64 dataOffset = header->dataOffset;
+
+    if (!isRangeValid(dataOffset + variantRecord->nameOffset, variantRecord->nameSize) ||
+            !isRangeValid(dataOffset + variantRecord->svgOffset, variantRecord->svgSize) ||
+            !isRangeValid(dataOffset + variantRecord->pathOffset,
+                          quint64(variantRecord->pathSize) * sizeof(PathElement)))
+        return nullptr;
+
+    return variantRecord;
+}
+
+bool GlyphPack::isRangeValid(quint64 offset, quint64 length, quint64 alignment) const
+{
+    //offsets and lengths are at most 2^32 * sizeof(VariantRecord), so the sum can't overflow
+    return offset % alignment == 0 && offset + length <= quint64(size);
+}
+
+bool GlyphPack::write(const QString &fileName, QVector<Variant> variants)
+{
+    std::stable_sort(variants.begin(), variants.end(), [](const Variant &left, const Variant &right)
+    {
+        return left.symbol < right.symbol;
+    });
+
+    QVector<SymbolEntry> symbols;
+    QVector<VariantRecord> records;
+    QByteArray blob;
+
+    auto append = [&blob](const QByteArray &bytes) -> quint32
+    {
+        quint32 offset = blob.size();
+        blob.append(bytes);
+        blob.append(QByteArray((4 - blob.size() % 4) % 4, '\0')); //the next part is aligned
+        return offset;
+    };
+
+    for (const Variant &variant : variants)
+    {
+        if (symbols.isEmpty() || symbols.last().code != variant.symbol.unicode())
+            symbols.push_back({variant.symbol.unicode(), quint32(records.size()), 0});
+
+        symbols.last().variantCount++;
+
+        const SymbolData &symbolData = variant.symbolData;
+        VariantRecord record;
+        record.inPoint[0] = symbolData.inPoint.x();
+        record.inPoint[1] = symbolData.inPoint.y();
+        record.outPoint[0] = symbolData.outPoint.x();
+        record.outPoint[1] = symbolData.outPoint.y();
+        record.limits[0] = symbolData.limits.x();
+        record.limits[1] = symbolData.limits.y();
+        record.limits[2] = symbolData.limits.width();
+        record.limits[3] = symbolData.limits.height();
+        record.symbolIndex = symbols.size() - 1;
+
+        QByteArray name = symbolData.fileName.toUtf8();
+        record.nameOffset = append(name);
+        record.nameSize = name.size();
+        record.svgOffset = append(variant.svg);
+        record.svgSize = variant.svg.size();
+
+        //strokes are parsed once here instead of every loading of the font
+        SvgRestyler restyler;
+        bool isGeometrySupported = false;
+        QPainterPath path;
+
+        if (restyler.restyle(variant.svg))
+            path = restyler.path(&isGeometrySupported);
+
+        QVector<PathElement> elements;
+
+        for (int i = 0; i < path.elementCount(); i++)
+        {
+            const QPainterPath::Element &element = path.elementAt(i);
+            elements.push_back({float(element.x), float(element.y), quint32(element.type)});
+        }
+
+        record.pathOffset = append(QByteArray(reinterpret_cast<const char *>(elements.constData()),
+                                              elements.size() * sizeof(PathElement)));
+        record.pathSize = elements.size();
+        record.flags = isGeometrySupported ? hasPathFlag : 0;
+        records.push_back(record);
+    }
+
+    //records hold doubles, so they begin at a multiple of their alignment
+    auto aligned = [](quint32 offset) -> quint32
+    {
+        return (offset + alignof(VariantRecord) - 1) / alignof(VariantRecord) * alignof(VariantRecord);
+    };
+
+    Header header;
+    std::copy(packMagic, packMagic + 4, header.magic);
+    header.version = packVersion;
+    header.symbolCount = symbols.size();
+    header.variantCount = records.size();
+    header.symbolsOffset = sizeof(Header);
+    header.variantsOffset = aligned(header.symbolsOffset + symbols.size() * sizeof(SymbolEntry));
+    header.dataOffset = aligned(header.variantsOffset + records.size() * sizeof(VariantRecord));
+    header.dataSize = blob.size();
+
+    if (QSysInfo::ByteOrder != QSysInfo::LittleEndian)
+        return false;
+
+    QSaveFile file(fileName);
+
+    if (!file.open(QIODevice::WriteOnly))
+        return false;
+
+    file.write(reinterpret_cast<const char *>(&header), sizeof(Header));
+    file.write(reinterpret_cast<const char *>(symbols.constData()), symbols.size() * sizeof(SymbolEntry));
+    file.write(QByteArray(header.variantsOffset - file.pos(), '\0'));
+    file.write(reinterpret_cast<const char *>(records.constData()), records.size() * sizeof(VariantRecord));
+    file.write(QByteArray(header.dataOffset - file.pos(), '\0'));
+    file.write(blob);
+
+    return file.commit();
+}
+
+bool GlyphPack::convertFont(const QString &fontFileName, const QString &packFileName)
+{
+    QSettings fontSettings(fontFileName, QSettings::IniFormat);
+    fontSettings.beginGroup("Font");
+    fontSettings.setIniCodec(QTextCodec::codecForName("UTF-8"));
+
+    if (fontSettings.allKeys().size() == 0)
+        return false;
+
+    QString fontDirectory = QFileInfo(fontFileName).path() + '/';
+    QVector<Variant> variants;
+
+    auto addVariants = [&](QChar symbol, const QList<SymbolData> &dataList)
+    {
+        for (const SymbolData &symbolData : dataList)
+        {
+            QFile svgFile(fontDirectory + symbolData.fileName);
+
+            if (!svgFile.open(QIODevice::ReadOnly))
+                continue;
+
+            variants.push_back({symbol, symbolData, svgFile.readAll()});
+        }
+    };
+
+    for (const QString &key : fontSettings.childKeys())
+    {
+        QList<SymbolData> dataList = fontSettings.value(key).value<QList<SymbolData>>();
+
+        if (key == "slash")
+            addVariants('/', dataList);
+        else if (key == "backslash")
+            addVariants('\\', dataList);
+        else
+            addVariants(key.at(0), dataList);
+    }
+
+    //uppercase letters are in their own group, see FontDialog::saveFont()
+    fontSettings.beginGroup("UpperCase");
+    for (const QString &key : fontSettings.childKeys())
+        addVariants(key.at(0), fontSettings.value(key).value<QList<SymbolData>>());
+    fontSettings.endGroup();
+
+    fontSettings.endGroup();
+
+    return !variants.isEmpty() && write(packFileName, variants);
+}
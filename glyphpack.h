@@ -0,0 +1,78 @@
+/*!
+    GlyphPack - a handwritten font in one file.
+
+    A usual font is an INI file and a folder of SVG images. A glyph pack
+    holds the same data in a file that is mapped into memory and read
+    without parsing:
+
+      * a header with offsets of the other parts;
+      * an index of symbols sorted by their UTF-16 code, every entry
+        points to the first variant of the symbol and their number;
+      * a fixed-size record of every variant: SymbolData, the size of
+        the image and offsets of its data;
+      * data: file names, original SVG images and strokes of the images
+        as path elements of floats, which SheetLayout uses instead of
+        parsing the path data again.
+
+    Numbers are little-endian, variant records are aligned to eight bytes
+    and everything else to four, so they are used straight from the
+    mapped file. Packs are made from INI fonts by convertFont(), which is
+    called by "Scribbler --glyph-pack font.ini font.sgp" and by the Font
+    Editor, when it saves an opened pack.
+*/
+#ifndef GLYPHPACK_H
+#define GLYPHPACK_H
+
+#include <QtCore/QByteArray>
+#include <QtCore/QFile>
+#include <QtCore/QString>
+#include <QtCore/QVector>
+#include <QtGui/QPainterPath>
+
+#include "symboldata.h"
+
+class GlyphPack
+{
+public:
+    struct Variant
+    {
+        QChar symbol;
+        SymbolData symbolData; //!< fileName is the name of the image in the font folder
+        QByteArray svg;        //!< points into the mapped file when it's read from a pack
+    };
+
+    GlyphPack();
+    ~GlyphPack();
+
+    static bool isGlyphPack(const QString &fileName); //!< checks the magic number of the file
+
+    bool open(const QString &fileName); //!< maps the file
+    void close();
+    bool isOpen() const {return header != nullptr;}
+    QString fileName() const {return file.fileName();}
+
+    int variantCount() const;
+    Variant variant(int index) const;
+    bool variantPath(int index, QPainterPath &path) const; //!< false if the image isn't just strokes
+    int findFile(const QString &fileName) const;           //!< index of the variant, or -1
+
+    static bool write(const QString &fileName, QVector<Variant> variants);
+    static bool convertFont(const QString &fontFileName, const QString &packFileName); //!< INI font to a pack
+
+private:
+    struct Header;
+    struct SymbolEntry;
+    struct VariantRecord;
+    struct PathElement;
+
+    QFile file;
+    const uchar *data;
+    qint64 size;
+    const Header *header;
+
+    const VariantRecord * record(int index) const;
+    //! the range lies inside of the file and begins at a multiple of alignment
+    bool isRangeValid(quint64 offset, quint64 length, quint64 alignment = 4) const;
+};
+
+#endif // GLYPHPACK_H
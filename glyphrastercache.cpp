@@ -0,0 +1,213 @@
+#include "glyphrastercache.h"
+
+#include <QtCore/QDataStream>
+#include <QtCore/QDateTime>
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QPair>
+#include <QtCore/QSaveFile>
+#include <QtCore/QStandardPaths>
+#include <QtCore/QVector>
+#include <algorithm>
+
+namespace
+{
+const quint32 imageMagic = 0x53474331; //"SGC1"
+const quint32 indexMagic = 0x53474931; //"SGI1"
+}
+
+GlyphRasterCache::GlyphRasterCache(const QString &directory)
+{
+    cacheDirectory = directory.isEmpty()
+            ? QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/glyphs"
+            : directory;
+    maxSize = 0;
+    totalSize = 0;
+    isIndexLoaded = false;
+    isIndexChanged = false;
+}
+
+GlyphRasterCache::~GlyphRasterCache()
+{
+    save();
+}
+
+void GlyphRasterCache::setMaxSize(qint64 bytes)
+{
+    maxSize = qMax(Q_INT64_C(0), bytes);
+
+    if (isEnabled())
+    {
+        loadIndex();
+        evict();
+    }
+}
+
+QImage GlyphRasterCache::find(const QByteArray &key)
+{
+    if (!isEnabled() || key.isEmpty())
+        return QImage();
+
+    loadIndex();
+    QHash<QByteArray, Entry>::iterator entry = entries.find(key.toHex());
+
+    if (entry == entries.end())
+        return QImage();
+
+    QFile file(filePath(key));
+
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        totalSize -= entry->size;
+        entries.erase(entry);
+        isIndexChanged = true;
+        return QImage();
+    }
+
+    QDataStream in(&file);
+    quint32 magic, width, height;
+    in >> magic >> width >> height;
+
+    QImage image;
+
+    if (magic == imageMagic && width > 0 && height > 0 && width <= 16384 && height <= 16384)
+    {
+        image = QImage(width, height, QImage::Format_ARGB32_Premultiplied);
+
+        for (int y = 0; y < image.height(); y++)
+            in.readRawData(reinterpret_cast<char *>(image.scanLine(y)), width * 4);
+
+        if (in.status() != QDataStream::Ok)
+            image = QImage();
+    }
+
+    if (image.isNull()) //the file is broken, it will be rewritten
+        return QImage();
+
+    entry->lastUsed = QDateTime::currentMSecsSinceEpoch();
+    isIndexChanged = true;
+
+    return image;
+}
+
+void GlyphRasterCache::insert(const QByteArray &key, const QImage &image)
+{
+    if (!isEnabled() || key.isEmpty() || image.isNull())
+        return;
+
+    loadIndex();
+
+    if (!QDir().mkpath(cacheDirectory))
+        return;
+
+    QImage pixels = image.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+    QSaveFile file(filePath(key));
+
+    if (!file.open(QIODevice::WriteOnly))
+        return;
+
+    QDataStream out(&file);
+    out << imageMagic << quint32(pixels.width()) << quint32(pixels.height());
+
+    for (int y = 0; y < pixels.height(); y++)
+        out.writeRawData(reinterpret_cast<const char *>(pixels.constScanLine(y)), pixels.width() * 4);
+
+    if (!file.commit())
+        return;
+
+    QByteArray name = key.toHex();
+    Entry &entry = entries[name];
+    totalSize += file.size() - entry.size;
+    entry.size = file.size();
+    entry.lastUsed = QDateTime::currentMSecsSinceEpoch();
+    isIndexChanged = true;
+
+    if (totalSize > maxSize)
+        evict();
+}
+
+void GlyphRasterCache::save()
+{
+    if (!isIndexChanged)
+        return;
+
+    QSaveFile file(cacheDirectory + "/index");
+
+    if (!QDir().mkpath(cacheDirectory) || !file.open(QIODevice::WriteOnly))
+        return;
+
+    QDataStream out(&file);
+    out << indexMagic << quint32(entries.size());
+
+    for (QHash<QByteArray, Entry>::const_iterator i = entries.constBegin(); i != entries.constEnd(); ++i)
+        out << i.key() << i->size << i->lastUsed;
+
+    if (file.commit())
+        isIndexChanged = false;
+}
+
+QString GlyphRasterCache::filePath(const QByteArray &key) const
+{
+    return cacheDirectory + '/' + QString::fromLatin1(key.toHex());
+}
+
+void GlyphRasterCache::loadIndex()
+{
+    if (isIndexLoaded)
+        return;
+
+    isIndexLoaded = true;
+    QFile file(cacheDirectory + "/index");
+
+    if (!file.open(QIODevice::ReadOnly))
+        return;
+
+    QDataStream in(&file);
+    quint32 magic, count;
+    in >> magic >> count;
+
+    if (magic != indexMagic)
+        return;
+
+    for (quint32 i = 0; i < count && in.status() == QDataStream::Ok; i++)
+    {
+        QByteArray name;
+        Entry entry;
+        in >> name >> entry.size >> entry.lastUsed;
+
+        if (in.status() == QDataStream::Ok)
+        {
+            entries.insert(name, entry);
+            totalSize += entry.size;
+        }
+    }
+}
+
+void GlyphRasterCache::evict()
+{
+    if (totalSize <= maxSize)
+        return;
+
+    QVector<QPair<qint64, QByteArray>> ages;
+    ages.reserve(entries.size());
+
+    for (QHash<QByteArray, Entry>::const_iterator i = entries.constBegin(); i != entries.constEnd(); ++i)
+        ages.push_back(qMakePair(i->lastUsed, i.key()));
+
+    std::sort(ages.begin(), ages.end());
+
+    //remove a bit more than necessary, so the next insertions don't evict again
+    qint64 targetSize = maxSize - maxSize / 10;
+
+    for (const QPair<qint64, QByteArray> &age : ages)
+    {
+        if (totalSize <= targetSize)
+            break;
+
+        QFile::remove(cacheDirectory + '/' + QString::fromLatin1(age.second));
+        totalSize -= entries.value(age.second).size;
+        entries.remove(age.second);
+    }
+
+    isIndexChanged = true;
+}
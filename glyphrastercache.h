@@ -0,0 +1,50 @@
+/*!
+    GlyphRasterCache - rasterized glyphs stored on disk between runs.
+
+    Every entry is a cell of GlyphAtlas saved as raw premultiplied pixels.
+    Its key is a hash of the SVG file and all settings that
+    SheetLayout::prepareSymbol() uses to restyle and scale a glyph, plus the
+    subpixel offset, so a changed file or setting never hits an old entry.
+
+    The total size of files is limited; when it's exceeded, the least
+    recently used entries are removed. Sizes and access times are kept
+    in an index file, which is written by save().
+*/
+#ifndef GLYPHRASTERCACHE_H
+#define GLYPHRASTERCACHE_H
+
+#include <QtCore/QByteArray>
+#include <QtCore/QHash>
+#include <QtCore/QString>
+#include <QtGui/QImage>
+
+class GlyphRasterCache
+{
+public:
+    explicit GlyphRasterCache(const QString &directory = QString());
+    ~GlyphRasterCache();
+
+    QImage find(const QByteArray &key);
+    void insert(const QByteArray &key, const QImage &image);
+    void setMaxSize(qint64 bytes); //!< 0 disables the cache
+    bool isEnabled() const {return maxSize > 0;}
+    void save();
+
+private:
+    struct Entry
+    {
+        qint64 size = 0;
+        qint64 lastUsed = 0; //!< milliseconds since epoch
+    };
+
+    QString cacheDirectory;
+    qint64 maxSize, totalSize;
+    QHash<QByteArray, Entry> entries; //!< keys are hex strings, they are also names of files
+    bool isIndexLoaded, isIndexChanged;
+
+    QString filePath(const QByteArray &key) const;
+    void loadIndex();
+    void evict();
+};
+
+#endif // GLYPHRASTERCACHE_H
@@ -1,4 +1,5 @@
 #include "mainwindow.h"
+#include "glyphpack.h"
 #include <QApplication>
 #include <QTranslator>
 
@@ -9,6 +10,11 @@ int main(int argc, char *argv[])
     qRegisterMetaTypeStreamOperators<QList<SymbolData>>("QList<SymbolData>");
     QApplication a(argc, argv);
 
+    //"Scribbler --glyph-pack font.ini font.sgp" converts the font and exits
+    QStringList arguments = a.arguments();
+    if (arguments.size() == 4 && arguments.at(1) == "--glyph-pack")
+        return GlyphPack::convertFont(arguments.at(2), arguments.at(3)) ? 0 : 1;
+
     QTranslator myTranslator;
     myTranslator.load("Scribbler-" + QLocale::system().name(), "translations");
     a.installTranslator(&myTranslator);
@@ -42,11 +42,27 @@ MainWindow::MainWindow(QWidget *parent) :
     connect(ui->toolBar, SIGNAL(visibilityChanged(bool)),
             ui->actionShow_ToolBar, SLOT(setChecked(bool)));
 
+    //connect menu action "Show Sheet Thumbnails"
+    connect(ui->actionShow_Thumbnails, SIGNAL(triggered(bool)),
+            ui->thumbnailDock, SLOT(setVisible(bool)));
+    connect(ui->thumbnailDock, SIGNAL(visibilityChanged(bool)),
+            ui->actionShow_Thumbnails, SLOT(setChecked(bool)));
+    connect(ui->thumbnailDock, SIGNAL(visibilityChanged(bool)),
+            this, SLOT(resumeThumbnails(bool)));
+    connect(ui->thumbnailList, SIGNAL(itemClicked(QListWidgetItem*)),
+            this, SLOT(showThumbnailSheet(QListWidgetItem*)));
+
+    //connect menu action "Show Paint Statistics"
+    connect(ui->actionShow_Paint_Statistics, SIGNAL(triggered(bool)),
+            ui->svgView, SLOT(setPaintStatisticsShown(bool)));
+
     //preferencesDialog connections
     connect(ui->actionPreferences, SIGNAL(triggered()),
             preferencesDialog, SLOT(exec()));
     connect(preferencesDialog, SIGNAL(settingsChanged()),
             this, SLOT(loadSettings()));
+    connect(preferencesDialog, SIGNAL(penChanged(qreal,QColor,bool,bool)),
+            ui->svgView, SLOT(previewPen(qreal,QColor,bool,bool)));
 
     //----Help----
     connect(ui->actionAbout_Scribbler, SIGNAL(triggered()),
@@ -75,6 +91,8 @@ MainWindow::MainWindow(QWidget *parent) :
 
     connect(fontDialog, SIGNAL(fontReady()),
             this, SLOT(updateCurrentSheet()));
+    connect(fontDialog, SIGNAL(glyphPackWriting(QString)),
+            this, SLOT(releaseGlyphPack(QString)));
     errorMessage->setModal(true);
     errorMessage->setWindowFlags(Qt::WindowTitleHint | Qt::WindowSystemMenuHint | Qt::WindowCloseButtonHint);
 
@@ -90,6 +108,52 @@ MainWindow::MainWindow(QWidget *parent) :
     //initialize some class members
     sheetPointers.push_back(0);
     currentSheetNumber = 0;
+    isExporting = false;
+    sheetRecords.setMaxCost(32 * 1024); //kilobytes, see loadSettings()
+
+    exportProgress = nullptr;
+    editPosition = -1;
+    previewRequest = -1;
+    previewPosition = 0;
+
+    previewTimer = new QTimer(this);
+    previewTimer->setSingleShot(true);
+    previewTimer->setInterval(300);
+    connect(previewTimer, SIGNAL(timeout()),
+            this, SLOT(updatePreview()));
+    connect(ui->textEdit->document(), SIGNAL(contentsChange(int,int,int)),
+            this, SLOT(registerEdit(int,int,int)));
+    connect(ui->svgView, SIGNAL(sheetsNeeded(int,int)),
+            this, SLOT(requestSheets(int,int)));
+    connect(ui->svgView, SIGNAL(currentSheetChanged(int)),
+            this, SLOT(followSheet(int)));
+    connect(ui->svgView, SIGNAL(fontLoadProgress(int,int)),
+            this, SLOT(showFontProgress(int,int)));
+
+    //the worker has its own font and settings; they are loaded in loadSettings()
+    renderThread = new QThread(this);
+    renderWorker = new RenderWorker();
+    renderWorker->moveToThread(renderThread);
+    connect(renderThread, SIGNAL(finished()),
+            renderWorker, SLOT(deleteLater()));
+    connect(renderWorker, SIGNAL(sheetReady(int,int,int,int,SheetDisplayList)),
+            this, SLOT(addSheetRecord(int,int,int,int,SheetDisplayList)));
+    connect(renderWorker, SIGNAL(exportFinished(int,bool)),
+            this, SLOT(finishExport(int,bool)));
+    renderThread->start();
+    renderRequest = exportRequest = renderWorker->newRequest();
+
+    //thumbnails are the least important work, so they have their own worker with a low priority
+    thumbnailThread = new QThread(this);
+    thumbnailWorker = new RenderWorker();
+    thumbnailWorker->moveToThread(thumbnailThread);
+    connect(thumbnailThread, SIGNAL(finished()),
+            thumbnailWorker, SLOT(deleteLater()));
+    connect(thumbnailWorker, SIGNAL(thumbnailReady(int,int,int,int,QImage)),
+            this, SLOT(addThumbnail(int,int,int,int,QImage)));
+    thumbnailThread->start(QThread::LowestPriority);
+    thumbnailRequest = thumbnailWorker->newRequest();
+    staleThumbnails = 0;
 
     preferencesDialog->loadSettingsFromFile();
     QTime dieTime = QTime::currentTime().addMSecs(1000);
@@ -100,6 +164,13 @@ MainWindow::MainWindow(QWidget *parent) :
 
 MainWindow::~MainWindow()
 {
+    renderWorker->newRequest(); //the running job stops after the current sheet
+    renderThread->quit();
+    renderThread->wait();
+    thumbnailWorker->newRequest();
+    thumbnailThread->quit();
+    thumbnailThread->wait();
+
     delete ui;
     delete preferencesDialog;
     delete fontDialog;
@@ -246,21 +317,23 @@ void MainWindow::renderFirstSheet()
 {
     sheetPointers.clear();
     sheetPointers.push_back(0);
-
-    currentSheetNumber = 0;
+    missedCharacters.clear();
+    sheetRecords.clear();
+    renderRequest = renderWorker->newRequest(); //sheets of the previous text are stale
+    previewTimer->stop();
+    editPosition = -1;
 
     text = ui->textEdit->toPlainText();
     text = simplifyEnd(text); //to avoid blank sheets at the end
-    int endOfSheet = ui->svgView->renderText(QStringRef(&text));
 
-    sheetPointers.push_back(endOfSheet);
-
-    bool isThereMoreThanOneSheet = (text.length() - 1) >= endOfSheet;
-    ui->toolBar->actions()[ToolButton::Next]->setEnabled(isThereMoreThanOneSheet);
-    ui->toolBar->actions()[ToolButton::Previous]->setDisabled(true);
+    if (ui->svgView->isContinuous())
+    {
+        ui->svgView->clearSheets();
+        ui->svgView->setSheetCount(1);
+    }
 
-    countMissedCharacters();
-    showSheetNumber(currentSheetNumber);
+    updateThumbnails(0);
+    showSheet(0);
 }
 
 void MainWindow::renderNextSheet()
@@ -268,58 +341,405 @@ void MainWindow::renderNextSheet()
     if (!ui->toolBar->actions()[ToolButton::Next]->isEnabled())
         return;
 
-    currentSheetNumber++;
+    showSheet(currentSheetNumber + 1);
+}
+
+void MainWindow::renderPreviousSheet()
+{
+    if (!ui->toolBar->actions()[ToolButton::Previous]->isEnabled())
+        return;
+
+    showSheet(currentSheetNumber - 1);
+}
+
+void MainWindow::updateCurrentSheet()
+{
+    ui->svgView->loadFont();
+    reloadRenderWorker();
+
+    //sheets after the current one begin at other characters with the new font
+    sheetPointers.resize(currentSheetNumber + 1);
+    sheetRecords.clear();
+    missedCharacters.clear(); //reports of other sheets were made with the previous font
+    ui->svgView->clearSheets();
+    updateThumbnails(0);
+    showSheet(currentSheetNumber);
+}
+
+void MainWindow::releaseGlyphPack(const QString &fileName)
+{
+    //the workers finish their current sheet first, updateCurrentSheet() loads the pack again
+    ui->svgView->releaseGlyphPack(fileName);
+    renderRequest = renderWorker->newRequest();
+    pendingSheets.clear();
+    QMetaObject::invokeMethod(renderWorker, "releaseGlyphPack", Qt::BlockingQueuedConnection,
+                              Q_ARG(QString, fileName));
+    thumbnailRequest = thumbnailWorker->newRequest();
+    QMetaObject::invokeMethod(thumbnailWorker, "releaseGlyphPack", Qt::BlockingQueuedConnection,
+                              Q_ARG(QString, fileName));
+}
+
+SheetDisplayList MainWindow::sheetRecord(int number, bool show)
+{
+    if (SheetDisplayList *record = sheetRecords.object(number))
+    {
+        if (show)
+            ui->svgView->showSheet(*record);
+
+        return *record;
+    }
 
-    if (preferencesDialog->alternateMargins())
-        ui->svgView->changeLeftRightMargins(currentSheetNumber % 2);
+    bool changedMargins = preferencesDialog->alternateMargins() && number % 2;
+    int lettersToTheEnd = text.length() - sheetPointers.at(number);
+    QStringRef sheetText(&text, sheetPointers.at(number), lettersToTheEnd);
+    SheetDisplayList sheet;
+    int endOfSheet;
+
+    if (show)
+    {
+        ui->svgView->changeLeftRightMargins(changedMargins);
+        endOfSheet = ui->svgView->renderText(sheetText);
+        sheet = ui->svgView->recordSheet();
+    }
     else
-        ui->svgView->changeLeftRightMargins(false);
+        endOfSheet = ui->svgView->layOutText(sheetText, changedMargins, sheet);
 
-    int lettersToTheEnd = text.length() - sheetPointers.at(currentSheetNumber);
-    int endOfSheet = ui->svgView->renderText(QStringRef(&text, sheetPointers.at(currentSheetNumber), lettersToTheEnd));
-    endOfSheet += sheetPointers.at(currentSheetNumber);
+    endOfSheet += sheetPointers.at(number);
 
-    ui->toolBar->actions()[ToolButton::Previous]->setEnabled(true);
-    showSheetNumber(currentSheetNumber);
+    if (number >= sheetPointers.count() - 1) //if this sheet has not yet been rendered,
+        sheetPointers.push_back(endOfSheet); //remember, where the next sheet begins
 
-    if (endOfSheet >= text.length())    //i.e. this sheet is the last
+    sheetRecords.insert(number, new SheetDisplayList(sheet), sheet.memoryCost() / 1024 + 1);
+    missedCharacters.insert(number, sheet.missingGlyphs);
+    return sheet;
+}
+
+void MainWindow::showSheet(int number)
+{
+    if (ui->svgView->isContinuous()) //all sheets are on the scene, the view scrolls to this one
     {
-        ui->toolBar->actions()[ToolButton::Next]->setDisabled(true);
+        ui->svgView->scrollToSheet(number);
+        followSheet(number);
+        prefetchSheets();
         return;
     }
 
-    if (currentSheetNumber >= sheetPointers.count() - 1) //if this sheet has not yet been rendered,
-        sheetPointers.push_back(endOfSheet);             //remember, where the next sheet begins
+    sheetRecord(number, true);
+    currentSheetNumber = number;
+    collectMissedCharacters(number, ui->svgView->getMissingGlyphs());
+
+    ui->toolBar->actions()[ToolButton::Previous]->setEnabled(number > 0);
+    ui->toolBar->actions()[ToolButton::Next]->setDisabled(isLastSheet(number));
+    showSheetNumber(number);
+
+    prefetchSheets();
 }
 
-void MainWindow::renderPreviousSheet()
+void MainWindow::prefetchSheets()
 {
-    if (!ui->toolBar->actions()[ToolButton::Previous]->isEnabled())
+    if (ui->svgView->isContinuous())
+    {
+        layOutRemainingSheets();
+        return;
+    }
+
+    if (!preferencesDialog->prefetchSheets())
         return;
 
-    currentSheetNumber--;
+    //neighbours of the previously shown sheet aren't needed anymore
+    renderRequest = renderWorker->newRequest();
+    QList<int> numbers;
+
+    if (!isLastSheet(currentSheetNumber) && !sheetRecords.contains(currentSheetNumber + 1))
+        numbers << currentSheetNumber + 1;
+    if (currentSheetNumber > 0 && !sheetRecords.contains(currentSheetNumber - 1))
+        numbers << currentSheetNumber - 1;
+
+    for (int number : numbers)
+        QMetaObject::invokeMethod(renderWorker, "layOutSheet", Qt::QueuedConnection,
+                                  Q_ARG(int, renderRequest), Q_ARG(QString, text),
+                                  Q_ARG(int, number), Q_ARG(int, sheetPointers.at(number)),
+                                  Q_ARG(bool, preferencesDialog->alternateMargins() && number % 2));
+}
+
+void MainWindow::layOutRemainingSheets()
+{
+    renderRequest = renderWorker->newRequest();
+    pendingSheets.clear();
+    int number = sheetPointers.size() - 1;
+
+    if (number == 0 || sheetPointers.at(number) < text.length())
+        QMetaObject::invokeMethod(renderWorker, "layOutSheetsUntil", Qt::QueuedConnection,
+                                  Q_ARG(int, renderRequest), Q_ARG(QString, text),
+                                  Q_ARG(int, number), Q_ARG(int, sheetPointers.at(number)),
+                                  Q_ARG(int, text.length()), Q_ARG(bool, preferencesDialog->alternateMargins()));
 
-    if (preferencesDialog->alternateMargins())
-        ui->svgView->changeLeftRightMargins(currentSheetNumber % 2);
+    ui->svgView->updateVisibleSheets(); //sheets that were requested by the previous job
+}
+
+void MainWindow::requestSheets(int first, int last)
+{
+    for (int number = first; number <= last && number < knownSheetCount(); number++)
+    {
+        if (SheetDisplayList *record = sheetRecords.object(number))
+            ui->svgView->setSheet(number, *record);
+        //sheets with an unknown end are on the way from layOutRemainingSheets()
+        else if (number + 1 < sheetPointers.size() && !pendingSheets.contains(number))
+        {
+            pendingSheets.insert(number);
+            QMetaObject::invokeMethod(renderWorker, "layOutSheet", Qt::QueuedConnection,
+                                      Q_ARG(int, renderRequest), Q_ARG(QString, text),
+                                      Q_ARG(int, number), Q_ARG(int, sheetPointers.at(number)),
+                                      Q_ARG(bool, preferencesDialog->alternateMargins() && number % 2));
+        }
+    }
+}
+
+void MainWindow::followSheet(int number)
+{
+    if (number >= knownSheetCount())
+        return;
+
+    currentSheetNumber = number;
+    ui->toolBar->actions()[ToolButton::Previous]->setEnabled(number > 0);
+    ui->toolBar->actions()[ToolButton::Next]->setEnabled(number + 1 < knownSheetCount());
+    showSheetNumber(number);
+}
+
+void MainWindow::showFontProgress(int loaded, int total)
+{
+    if (loaded == total)
+    {
+        ui->statusBar->clearMessage();
+        return;
+    }
+
+    //the font is loaded without returning to the event loop, so the bar is painted right away
+    ui->statusBar->showMessage(tr("Loading the font: %1 of %2 glyphs").arg(loaded).arg(total));
+    ui->statusBar->repaint();
+}
+
+int MainWindow::knownSheetCount() const
+{
+    int count = sheetPointers.size();
+
+    if (count > 1 && sheetPointers.last() >= text.length()) //the end of the last sheet
+        count--;
+
+    return count;
+}
+
+void MainWindow::addSheetRecord(int request, int number, int begin, int end, SheetDisplayList sheet)
+{
+    //even a stale sheet is adopted, else the last references to glyphs
+    //of the worker could be dropped here after the worker is reloaded
+    ui->svgView->adoptSheet(sheet);
+
+    //the text, the font or the settings could be changed after the request
+    if (request != renderRequest)
+        return;
+
+    pendingSheets.remove(number);
+
+    if (exportProgress != nullptr) //the report describes exported sheets
+    {
+        missedCharacters.insert(number, sheet.missingGlyphs);
+        exportProgress->setLabelText(tr("Sheet %1 is ready").arg(number + 1));
+    }
+
+    //without a seed the worker can lay the text out other way than the view did
+    if (number >= sheetPointers.size() || sheetPointers.at(number) != begin)
+        return;
+
+    if (number + 1 < sheetPointers.size() && sheetPointers.at(number + 1) != end)
+    {
+        ui->svgView->setSheet(number, sheet); //it's still better than blank paper
+        return;
+    }
+
+    if (ui->svgView->isContinuous()) //the sheet is on the scene, so it's reported as if shown
+        collectMissedCharacters(number, sheet.missingGlyphs);
     else
-        ui->svgView->changeLeftRightMargins(false);
+        missedCharacters.insert(number, sheet.missingGlyphs);
+
+    if (number + 1 == sheetPointers.size())
+        sheetPointers.push_back(end);
+
+    sheetRecords.insert(number, new SheetDisplayList(sheet), sheet.memoryCost() / 1024 + 1);
+
+    if (ui->svgView->isContinuous())
+    {
+        //places of old sheets stay until the new last sheet is known
+        if (end >= text.length() || knownSheetCount() > ui->svgView->sheetCount())
+            ui->svgView->setSheetCount(knownSheetCount());
+
+        ui->svgView->setSheet(number, sheet);
+        followSheet(currentSheetNumber);
+    }
+
+    if (request == previewRequest && (end > previewPosition || end >= text.length()))
+    {
+        previewRequest = -1;
+
+        if (!ui->svgView->isContinuous()) //the continuous view has already got it
+            showSheet(number);
+    }
+}
+
+void MainWindow::registerEdit(int position, int charsRemoved, int charsAdded)
+{
+    Q_UNUSED(charsRemoved);
+    Q_UNUSED(charsAdded);
+
+    if (!preferencesDialog->livePreview())
+        return;
+
+    if (editPosition < 0 || position < editPosition)
+        editPosition = position;
+
+    previewTimer->start();
+}
+
+void MainWindow::updatePreview()
+{
+    if (editPosition < 0 || isExporting)
+        return;
+
+    text = ui->textEdit->toPlainText();
+    text = simplifyEnd(text);
+    int position = qMin(editPosition, text.length());
+    int number = sheetOfPosition(position);
+    editPosition = -1;
 
-    int lettersToTheEnd = text.length() - sheetPointers.at(currentSheetNumber);
-    ui->svgView->renderText(QStringRef(&text, sheetPointers.at(currentSheetNumber), lettersToTheEnd));
+    //sheets before the edited one keep their text, the others are laid out again on demand
+    sheetPointers.resize(number + 1);
 
-    ui->toolBar->actions()[ToolButton::Next]->setEnabled(true);
+    for (int key : sheetRecords.keys())
+        if (key >= number)
+            sheetRecords.remove(key);
 
-    if (currentSheetNumber == 0)
+    missedCharacters.erase(missedCharacters.lowerBound(number), missedCharacters.end());
+
+    //the old sheet stays on screen, but there are no pointers to its neighbours until the new one comes
+    if (!ui->svgView->isContinuous())
+    {
+        currentSheetNumber = qMin(currentSheetNumber, number);
+        ui->toolBar->actions()[ToolButton::Next]->setDisabled(true);
         ui->toolBar->actions()[ToolButton::Previous]->setDisabled(true);
+    }
 
-    showSheetNumber(currentSheetNumber);
+    renderRequest = previewRequest = renderWorker->newRequest();
+    previewPosition = position;
+    pendingSheets.clear();
+    updateThumbnails(number);
+
+    //the continuous view shows all sheets, so all of them are laid out again
+    int lastPosition = ui->svgView->isContinuous() ? text.length() : position;
+    QMetaObject::invokeMethod(renderWorker, "layOutSheetsUntil", Qt::QueuedConnection,
+                              Q_ARG(int, previewRequest), Q_ARG(QString, text),
+                              Q_ARG(int, number), Q_ARG(int, sheetPointers.at(number)),
+                              Q_ARG(int, lastPosition), Q_ARG(bool, preferencesDialog->alternateMargins()));
 }
 
-void MainWindow::updateCurrentSheet()
+int MainWindow::sheetOfPosition(int position) const
 {
-    ui->svgView->loadFont();
-    int lettersToTheEnd = text.length() - sheetPointers.at(currentSheetNumber);
-    ui->svgView->renderText(QStringRef(&text, sheetPointers.at(currentSheetNumber), lettersToTheEnd));
+    int number = sheetPointers.size() - 1;
+
+    while (number > 0 && sheetPointers.at(number) > position)
+        number--;
+
+    //the first word of a sheet can move to the previous one after it's shortened
+    if (number > 0)
+    {
+        int i = sheetPointers.at(number);
+
+        while (i < position && !text.at(i).isSpace())
+            i++;
+
+        if (i == position)
+            number--;
+    }
+
+    return number;
+}
+
+void MainWindow::reloadRenderWorker()
+{
+    renderRequest = renderWorker->newRequest();
+    pendingSheets.clear();
+    QMetaObject::invokeMethod(renderWorker, "reload", Qt::QueuedConnection);
+
+    thumbnailRequest = thumbnailWorker->newRequest();
+    QMetaObject::invokeMethod(thumbnailWorker, "reload", Qt::QueuedConnection);
+}
+
+void MainWindow::updateThumbnails(int first)
+{
+    thumbnailRequest = thumbnailWorker->newRequest();
+
+    if (staleThumbnails < 0 || first < staleThumbnails)
+        staleThumbnails = first;
+
+    if (thumbnailBegins.size() > staleThumbnails + 1) //the beginning of the first stale sheet is still right
+        thumbnailBegins.resize(staleThumbnails + 1);
+
+    if (!ui->thumbnailDock->isVisible()) //resumeThumbnails() starts it later
+        return;
+
+    int number = qMin(staleThumbnails, sheetPointers.size() - 1);
+    staleThumbnails = -1;
+    QMetaObject::invokeMethod(thumbnailWorker, "renderThumbnails", Qt::QueuedConnection,
+                              Q_ARG(int, thumbnailRequest), Q_ARG(QString, text),
+                              Q_ARG(int, number), Q_ARG(int, sheetPointers.at(number)),
+                              Q_ARG(bool, preferencesDialog->alternateMargins()), Q_ARG(int, thumbnailWidth));
+}
+
+void MainWindow::resumeThumbnails(bool visible)
+{
+    if (visible && staleThumbnails >= 0)
+        updateThumbnails(staleThumbnails);
+}
+
+void MainWindow::addThumbnail(int request, int number, int begin, int end, QImage image)
+{
+    if (request != thumbnailRequest)
+        return;
+
+    thumbnailBegins.resize(number + 2);
+    thumbnailBegins[number] = begin;
+    thumbnailBegins[number + 1] = end;
+
+    while (ui->thumbnailList->count() <= number)
+        new QListWidgetItem(QString::number(ui->thumbnailList->count() + 1), ui->thumbnailList);
+
+    ui->thumbnailList->setIconSize(image.size());
+    ui->thumbnailList->item(number)->setIcon(QIcon(QPixmap::fromImage(image)));
+
+    if (end >= text.length()) //the text became shorter
+        while (ui->thumbnailList->count() > number + 1)
+            delete ui->thumbnailList->takeItem(number + 1);
+}
+
+void MainWindow::showThumbnailSheet(QListWidgetItem *item)
+{
+    int number = ui->thumbnailList->row(item);
+
+    //the thumbnail worker finds the same beginnings of sheets when the layout has a seed
+    while (sheetPointers.size() <= number && sheetPointers.size() < thumbnailBegins.size() &&
+           thumbnailBegins.at(sheetPointers.size() - 1) == sheetPointers.last())
+        sheetPointers.push_back(thumbnailBegins.at(sheetPointers.size()));
+
+    //otherwise the sheets before it are laid out here
+    while (sheetPointers.size() <= number && sheetPointers.last() < text.length())
+        sheetRecord(sheetPointers.size() - 1);
+
+    if (number < knownSheetCount())
+        showSheet(number);
+}
+
+bool MainWindow::isLastSheet(int number) const
+{
+    return sheetPointers.at(number + 1) >= text.length();
 }
 
 void MainWindow::loadFont()
@@ -327,6 +747,8 @@ void MainWindow::loadFont()
     QString fileName = QFileDialog::getOpenFileName(0, tr("Open"), "",
                                               tr("INI") +
                                                  "(*.ini);;" +
+                                              tr("Glyph Pack") +
+                                                 "(*.sgp);;" +
                                               tr("All Files") +
                                                  "(*.*)");
     if (fileName.isEmpty())
@@ -340,6 +762,12 @@ void MainWindow::loadFont()
     file.close();
 
     ui->svgView->loadFont(fileName);
+    sheetRecords.clear();
+    reloadRenderWorker();
+    updateThumbnails(0);
+
+    if (ui->svgView->isContinuous()) //every shown sheet would be in the old font
+        renderFirstSheet();
 }
 
 void MainWindow::saveSheet(QString fileName)
@@ -353,9 +781,7 @@ void MainWindow::saveSheet(QString fileName)
     if (fileName.isEmpty())
         return;
 
-    ui->svgView->hideBorders(true);
-    ui->svgView->saveRenderToImage().save(fileName);
-    ui->svgView->hideBorders(false);
+    ui->svgView->renderToImage(sheetRecord(currentSheetNumber)).save(fileName);
 }
 
 void MainWindow::saveAllSheets()
@@ -377,68 +803,57 @@ void MainWindow::saveAllSheets()
 
 void MainWindow::saveAllSheetsToImages(const QString &fileName)
 {
-    int indexOfExtension = fileName.indexOf(QRegularExpression("\\.\\w+$"), 0);
-    QString currentFileName;
-    currentSheetNumber = -1;
-    ui->toolBar->actions()[ToolButton::Next]->setEnabled(true);
-    ui->svgView->hideBorders(true);
-
-    while (ui->toolBar->actions()[ToolButton::Next]->isEnabled()) //while "Next Sheet" tool button is enabled,
-    {                                                             //i.e. while rendering all sheets
-        renderNextSheet();
-        currentFileName = fileName;
-
-        if (currentSheetNumber > 0 || ui->toolBar->actions()[ToolButton::Next]->isEnabled())
-            //i.e. there is more than one sheet
-            currentFileName.insert(indexOfExtension, QString("_%1").arg(currentSheetNumber));
-
-        saveSheet(currentFileName);
-    }
-
-    ui->svgView->hideBorders(false);
-
-    //we used renderNextSheet() for the first sheet instead of renderFirstSheet()
-    //so we need to check the number of sheet and disable previous toolbutton if needed
-    if (currentSheetNumber == 0)
-        ui->toolBar->actions()[ToolButton::Previous]->setDisabled(true);
+    startExport(fileName);
+    QMetaObject::invokeMethod(renderWorker, "exportImages", Qt::QueuedConnection,
+                              Q_ARG(int, exportRequest), Q_ARG(QString, text), Q_ARG(QString, fileName),
+                              Q_ARG(bool, preferencesDialog->alternateMargins()));
 }
 
 void MainWindow::saveAllSheetsToPDF(const QString &fileName)
 {
-    QPrinter printer(QPrinter::PrinterResolution);
-    printer.setOutputFormat(QPrinter::PdfFormat);
-    printer.setOutputFileName(fileName);
-    preparePrinter(&printer);
-
-    QPainter painter(&printer);
-    painter.setRenderHint(QPainter::Antialiasing);
-
-    currentSheetNumber = -1;
-    ui->toolBar->actions()[ToolButton::Next]->setEnabled(true);
-    ui->svgView->hideBorders(true);
-
-    while (ui->toolBar->actions()[ToolButton::Next]->isEnabled()) //while "Next Sheet" tool button is enabled,
-    {                                                             //i.e. while printing all sheets
-        renderNextSheet();
+    startExport(fileName);
+    QMetaObject::invokeMethod(renderWorker, "exportPdf", Qt::QueuedConnection,
+                              Q_ARG(int, exportRequest), Q_ARG(QString, text), Q_ARG(QString, fileName),
+                              Q_ARG(bool, preferencesDialog->alternateMargins()));
+}
 
-        QImage image = ui->svgView->saveRenderToImage();
+void MainWindow::startExport(const QString &fileName)
+{
+    renderRequest = exportRequest = renderWorker->newRequest();
+    exportFileName = fileName;
+    isExporting = true;
+
+    exportProgress = new QProgressDialog(tr("Laying out sheets..."), tr("Cancel"), 0, 0, this);
+    exportProgress->setWindowModality(Qt::WindowModal);
+    exportProgress->setMinimumDuration(0);
+    connect(exportProgress, SIGNAL(canceled()),
+            this, SLOT(cancelExport()));
+    exportProgress->show();
+}
 
-        if (image.format() == QImage::Format_Invalid || !printer.isValid())
-            return;
+void MainWindow::cancelExport()
+{
+    renderRequest = renderWorker->newRequest(); //the worker stops after the current sheet
+}
 
-        painter.drawImage(0, 0, image);
+void MainWindow::finishExport(int request, bool completed)
+{
+    if (request != exportRequest || exportProgress == nullptr)
+        return;
 
-        if (ui->toolBar->actions()[ToolButton::Next]->isEnabled()) //if "Next Sheet" tool button is enabled,
-            printer.newPage();                                     //i.e this sheet isn't the last one
-    }
+    exportProgress->deleteLater();
+    exportProgress = nullptr;
+    editPosition = -1;
+    previewRequest = -1;
+    previewPosition = 0;
+    isExporting = false;
 
-    painter.end();
-    ui->svgView->hideBorders(false);
+    if (completed)
+        saveMissedCharactersReport(exportFileName);
+    else
+        ui->statusBar->showMessage(tr("Saving is cancelled"));
 
-    //we used renderNextSheet() for the first sheet instead of renderFirstSheet()
-    //so we need to check the number of sheet and disable previous toolbutton if needed
-    if (currentSheetNumber == 0)
-        ui->toolBar->actions()[ToolButton::Previous]->setDisabled(true);
+    prefetchSheets();
 }
 
 void MainWindow::printSheet()
@@ -448,19 +863,15 @@ void MainWindow::printSheet()
     if (dialog.exec() != QPrintDialog::Accepted)
         return;
 
-    preparePrinter(&printer);
+    RenderWorker::preparePrinter(&printer);
 
     QPainter painter(&printer);
     painter.setRenderHint(QPainter::Antialiasing);
 
-    ui->svgView->hideBorders(true);
-    QImage image = ui->svgView->saveRenderToImage();
-    ui->svgView->hideBorders(false);
-
-    if (image.format() == QImage::Format_Invalid || !printer.isValid())
+    if (!printer.isValid())
         return;
 
-    painter.drawImage(0, 0, image);
+    ui->svgView->paintSheet(&painter, sheetRecord(currentSheetNumber), printer.resolution());
     painter.end();
 }
 
@@ -475,41 +886,40 @@ void MainWindow::printAllSheets()
     if (dialog.exec() != QPrintDialog::Accepted)
         return;
 
-    preparePrinter(&printer);
+    RenderWorker::preparePrinter(&printer);
 
     QPainter painter(&printer);
     painter.setRenderHint(QPainter::Antialiasing);
 
-    currentSheetNumber = -1;
-    ui->toolBar->actions()[ToolButton::Next]->setEnabled(true);
-    ui->svgView->hideBorders(true);
+    if (!printer.isValid())
+        return;
 
-    while (ui->toolBar->actions()[ToolButton::Next]->isEnabled()) //while "Next Sheet" tool button is enabled,
-    {                                                             //i.e. while printing all sheets
-        renderNextSheet();
+    isExporting = true;
+    bool isFirstPage = true;
 
-        if ((printer.fromPage() != 0 && printer.fromPage() > currentSheetNumber + 1)     //we're not going out of page range
-				|| (printer.toPage() != 0 && printer.toPage() < currentSheetNumber + 1)) //defined by user
-            continue;
+    for (int number = 0; ; number++)
+    {
+        if (printer.toPage() != 0 && printer.toPage() < number + 1) //we're not going out of page range
+            break;                                                  //defined by user
 
-        QImage image = ui->svgView->saveRenderToImage();
+        SheetDisplayList sheet = sheetRecord(number);
 
-        if (image.format() == QImage::Format_Invalid || !printer.isValid())
-            return;
+        if (printer.fromPage() == 0 || printer.fromPage() <= number + 1)
+        {
+            if (!isFirstPage)
+                printer.newPage();
 
-        painter.drawImage(0, 0, image);
+            ui->svgView->paintSheet(&painter, sheet, printer.resolution());
+            isFirstPage = false;
+        }
 
-        if (ui->toolBar->actions()[ToolButton::Next]->isEnabled()) //if "Next Sheet" tool button is enabled,
-            printer.newPage();                                     //i.e this sheet is not the last
-	}
+        if (isLastSheet(number))
+            break;
+    }
 
     painter.end();
-    ui->svgView->hideBorders(false);
-
-    //we used renderNextSheet() for the first sheet instead of renderFirstSheet()
-    //so we need to check the number of sheet and disable previous toolbutton if needed
-    if (currentSheetNumber == 0)
-        ui->toolBar->actions()[ToolButton::Previous]->setDisabled(true);
+    isExporting = false;
+    saveMissedCharactersReport(QString());
 }
 
 void MainWindow::loadTextFromFile()
@@ -532,7 +942,9 @@ void MainWindow::loadTextFromFile()
 
 void MainWindow::loadSettings()
 {
+    sheetRecords.setMaxCost(preferencesDialog->sheetCacheSize() * 1024);
     ui->svgView->loadSettingsFromFile();
+    reloadRenderWorker();
     int sheetNumber = currentSheetNumber;
     renderFirstSheet();
 
@@ -541,22 +953,6 @@ void MainWindow::loadSettings()
 
 }
 
-void MainWindow::preparePrinter(QPrinter *printer)
-{
-    QSettings settings("Settings.ini", QSettings::IniFormat);
-    settings.beginGroup("Settings");
-
-    QSizeF paperSize(settings.value("sheet-width", 210.0).toInt(), settings.value("sheet-height", 297.0).toInt());
-    bool isPortrait = settings.value("is-sheet-orientation-vertical", true).toBool();
-
-    printer->setPaperSize(paperSize, QPrinter::Millimeter);
-    printer->setResolution(settings.value("dpi", 300).toInt());
-    printer->setOrientation(isPortrait ? QPrinter::Portrait : QPrinter::Landscape);
-	printer->setDoubleSidedPrinting(true);
-
-    settings.endGroup();
-}
-
 QString MainWindow::simplifyEnd(const QString& str)
 {
     int n = str.size() - 1;
@@ -568,36 +964,75 @@ QString MainWindow::simplifyEnd(const QString& str)
     return "";
 }
 
-void MainWindow::countMissedCharacters()
+void MainWindow::collectMissedCharacters(int number, const MissingGlyphs &sheetReport)
+{
+    MissingGlyphs otherSheets;
+
+    for (auto it = missedCharacters.constBegin(); it != missedCharacters.constEnd(); ++it)
+        if (it.key() != number)
+            otherSheets.merge(it.value(), it.key());
+
+    QList<QChar> newCharacters;
+
+    for (const QChar &symbol : sheetReport.characters())
+        if (!otherSheets.counts.contains(symbol))
+            newCharacters << symbol;
+
+    missedCharacters.insert(number, sheetReport);
+
+    if (!isExporting)
+        showMissedCharacters(newCharacters);
+}
+
+MissingGlyphs MainWindow::missedCharactersReport() const
+{
+    MissingGlyphs report;
+
+    for (auto it = missedCharacters.constBegin(); it != missedCharacters.constEnd(); ++it)
+        report.merge(it.value(), it.key());
+
+    return report;
+}
+
+void MainWindow::saveMissedCharactersReport(const QString &fileName)
 {
-    QList<QChar> fontKeys = ui->svgView->getFontKeys();
-    QSet <QChar> missedCharacters;
+    MissingGlyphs report = missedCharactersReport();
 
-    for (const QChar &symbol : text)
-        if (!fontKeys.contains(symbol) && !symbol.isSpace())
-            missedCharacters << symbol;
+    if (report.isEmpty())
+        return;
+
+    ui->statusBar->showMessage(tr("%n character(s) missing in the font", "", report.counts.size()));
+
+    if (fileName.isEmpty())
+        return;
+
+    //the report is saved next to the exported sheets: letter.pdf -> letter.missing.json
+    QFileInfo fileInfo(fileName);
+    QFile file(fileInfo.path() + '/' + fileInfo.completeBaseName() + ".missing.json");
+
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
+        return;
+
+    file.write(QJsonDocument(report.toJson()).toJson());
+}
 
-    if (missedCharacters.isEmpty())
+void MainWindow::showMissedCharacters(const QList<QChar> &characters)
+{
+    if (characters.isEmpty())
         return;
 
     QString errorText, missedCharactersString;
-    int counter = 0;
 
-    for (const QChar &symbol : missedCharacters)
-    {
+    for (const QChar &symbol : characters)
         missedCharactersString += QString("%1, ").arg(symbol);
-        counter++;
 
-        if (counter > 10)
-            counter = 0;
-    }
     missedCharactersString.remove(-2, 2);
 
-    if (missedCharacters.count() == 1)
+    if (characters.count() == 1)
         errorText = tr("Character %1 is missing in the font! "
                        "Instead, there is space on the sheet.").arg(missedCharactersString);
 
-    if (errorText.isEmpty() && missedCharacters.count() <= 10)
+    if (errorText.isEmpty() && characters.count() <= 10)
     {
         missedCharactersString.remove(-3, 1);
         missedCharactersString.insert(missedCharactersString.size() - 1, tr("and "));
@@ -605,7 +1040,7 @@ void MainWindow::countMissedCharacters()
                        "Instead, there are spaces on the sheet.").arg(missedCharactersString);
     }
 
-    if (errorText.isEmpty() && missedCharacters.count() > 10)
+    if (errorText.isEmpty() && characters.count() > 10)
         errorText = tr("Some characters are missing in the font! "
                        "Instead, there are spaces on the sheet.<br><br>"
                        "List of missed characters:<br>") + missedCharactersString;
@@ -617,4 +1052,7 @@ void MainWindow::showSheetNumber(int number)
 {
     sheetNumberLabel->clear();
     sheetNumberLabel->setText(QString("<h2>%1</h2>").arg(number + 1));
+
+    if (number < ui->thumbnailList->count())
+        ui->thumbnailList->setCurrentRow(number);
 }
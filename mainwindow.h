@@ -15,18 +15,28 @@
 
 #include <QtCore/QTime>
 #include <QtCore/QTextStream>
+#include <QtCore/QJsonDocument>
+#include <QtCore/QCache>
+#include <QtCore/QThread>
+#include <QtCore/QTimer>
+#include <QtCore/QSet>
 #include <QtWidgets/QMainWindow>
 #include <QtWidgets/QFileDialog>
 #include <QtWidgets/QMessageBox>
 #include <QtWidgets/QScrollBar>
 #include <QtWidgets/QErrorMessage>
 #include <QtWidgets/QLabel>
+#include <QtWidgets/QProgressDialog>
+#include <QtWidgets/QListWidget>
 #include <QtPrintSupport/QPrintDialog>
 #include <QtPrintSupport/QPrinter>
 #include <QtGui/QWheelEvent>
 
 #include "preferencesdialog.h"
 #include "fontdialog.h"
+#include "missingglyphs.h"
+#include "sheetdisplaylist.h"
+#include "renderworker.h"
 
 namespace Ui {
 class MainWindow;
@@ -65,11 +75,42 @@ private:
     QVector<int> sheetPointers; //!< pointers to the first character of the sheets
     int currentSheetNumber;     //!< number of sheet that is displaying or rendering now
     QString text;
+    QMap<int, MissingGlyphs> missedCharacters; //!< characters missing in the font for every rendered sheet
+    QCache<int, SheetDisplayList> sheetRecords; //!< recently laid out sheets of the current text, settings and font; cost in KB
+    QSet<int> pendingSheets;                    //!< continuous view: sheets requested from renderWorker
+    QThread *renderThread;
+    RenderWorker *renderWorker;  //!< lays out neighbours of the shown sheet and exports sheets
+    int renderRequest;           //!< the latest job of renderWorker, results of older ones are dropped
+    int exportRequest;
+    QProgressDialog *exportProgress;
+    QString exportFileName;
+    QThread *thumbnailThread;
+    RenderWorker *thumbnailWorker;
+    int thumbnailRequest;
+    int staleThumbnails;         //!< the first sheet with an outdated thumbnail, -1 if all are up to date
+    QVector<int> thumbnailBegins; //!< beginnings of sheets found by thumbnailWorker and the end of the last one
+    static const int thumbnailWidth = 120;
+    QTimer *previewTimer;        //!< waits for a pause in typing
+    int editPosition;            //!< the first character changed since the last preview, -1 if none
+    int previewRequest;
+    int previewPosition;         //!< the sheet with this character is shown when it's ready
+    bool isExporting;                          //!< batch export or printing is in progress, don't show popups
 
+    SheetDisplayList sheetRecord(int number, bool show = false); //!< lays the sheet out if it isn't recorded yet
+    void showSheet(int number);
+    bool isLastSheet(int number) const; //!< the sheet must be laid out before
     void saveAllSheetsToImages(const QString &fileName);
     void saveAllSheetsToPDF(const QString &fileName);
-    void preparePrinter(QPrinter *printer);
+    void startExport(const QString &fileName);
+    void prefetchSheets();
+    void reloadRenderWorker(); //!< after the font or the settings are changed
+    void layOutRemainingSheets(); //!< continuous view: from the last known beginning to the end of the text
+    int knownSheetCount() const;  //!< sheets with known beginnings
+    void updateThumbnails(int first); //!< thumbnails from first are drawn again
+    int sheetOfPosition(int position) const; //!< the first laid out sheet that can change after an edit at position
     QString simplifyEnd(const QString &str); //!< returns string without whitespaces at the end
+    MissingGlyphs missedCharactersReport() const;
+    void saveMissedCharactersReport(const QString &fileName);
 
 private slots:
     void showAboutBox();
@@ -79,6 +120,7 @@ private slots:
     void renderNextSheet();
     void renderPreviousSheet();
     void updateCurrentSheet();
+    void releaseGlyphPack(const QString &fileName);
     void loadFont();
     void saveSheet(QString fileName = QString());
     void saveAllSheets();
@@ -86,8 +128,20 @@ private slots:
     void printAllSheets();
     void loadTextFromFile();
     void loadSettings();
-    void countMissedCharacters();
+    void collectMissedCharacters(int number, const MissingGlyphs &sheetReport);
+    void showMissedCharacters(const QList<QChar> &characters);
     void showSheetNumber(int number);
+    void registerEdit(int position, int charsRemoved, int charsAdded);
+    void updatePreview();
+    void requestSheets(int first, int last);
+    void resumeThumbnails(bool visible);
+    void addThumbnail(int request, int number, int begin, int end, QImage image);
+    void showThumbnailSheet(QListWidgetItem *item);
+    void followSheet(int number); //!< the continuous view is scrolled to the sheet
+    void showFontProgress(int loaded, int total);
+    void addSheetRecord(int request, int number, int begin, int end, SheetDisplayList sheet);
+    void cancelExport();
+    void finishExport(int request, bool completed);
     void on_actionShortcuts_triggered();
 };
 
@@ -0,0 +1,154 @@
+#include "mipmapbuilder.h"
+
+#include <QtConcurrent/QtConcurrentRun>
+
+namespace
+{
+const int glyphsInChunk = 100; //!< keeps every chunk well under a frame
+}
+
+MipmapBuilder::MipmapBuilder(QObject *parent) : QObject(parent)
+{
+    sheetItem = nullptr;
+    levelCount = 0;
+    nextGlyph = 0;
+    generation = 0;
+    scaledGeneration = -1;
+
+    chunkTimer.setInterval(0);
+    connect(&chunkTimer, SIGNAL(timeout()),
+            this, SLOT(renderChunk()));
+    connect(&watcher, SIGNAL(finished()),
+            this, SLOT(levelsReady()));
+}
+
+MipmapBuilder::~MipmapBuilder()
+{
+    cancel();
+    watcher.waitForFinished();
+}
+
+void MipmapBuilder::start(SheetItem *item, int levels)
+{
+    cancel();
+
+    sheetItem = item;
+    levelCount = qMax(1, levels);
+    nextGlyph = 0;
+
+    QSize size = item->boundingRect().size().toSize();
+
+    if (size.isEmpty())
+        return;
+
+    baseLevel = QImage(size, QImage::Format_ARGB32_Premultiplied);
+    baseLevel.fill(Qt::transparent);
+
+    //words and glyphs with renderers must not go to another thread, these glyphs are drawn here
+    strokeSheet = item->displayList();
+    strokeSheet.words.clear();
+    strokeSheet.glyphs.clear();
+    bool hasRenderers = false;
+
+    for (const PlacedGlyph &glyph : item->glyphs())
+    {
+        if (!glyph.visible)
+            continue;
+
+        if (glyph.svgData->renderer.isNull())
+        {
+            strokeSheet.glyphs.push_back(glyph);
+            strokeSheet.glyphs.last().word = -1;
+        }
+        else
+            hasRenderers = true;
+    }
+
+    if (hasRenderers)
+        chunkTimer.start();
+    else
+        renderLevels();
+}
+
+void MipmapBuilder::cancel()
+{
+    chunkTimer.stop();
+    generation++;
+    baseLevel = QImage();
+    strokeSheet = SheetDisplayList();
+}
+
+void MipmapBuilder::renderChunk()
+{
+    const QVector<PlacedGlyph> &glyphs = sheetItem->glyphs();
+    int end = qMin(nextGlyph + glyphsInChunk, glyphs.size());
+
+    QPainter painter(&baseLevel);
+    painter.setRenderHint(QPainter::Antialiasing);
+    painter.translate(-sheetItem->boundingRect().topLeft());
+
+    const QPen &glyphPen = sheetItem->displayList().glyphPen;
+
+    for (; nextGlyph < end; nextGlyph++)
+    {
+        const PlacedGlyph &glyph = glyphs.at(nextGlyph);
+
+        if (glyph.visible && !glyph.svgData->renderer.isNull())
+            glyph.svgData->draw(&painter, glyph.rect(), glyphPen);
+    }
+
+    painter.end();
+
+    if (nextGlyph < glyphs.size())
+        return;
+
+    chunkTimer.stop();
+    renderLevels();
+}
+
+void MipmapBuilder::renderLevels()
+{
+    scaledGeneration = generation;
+    watcher.setFuture(QtConcurrent::run(&MipmapBuilder::buildLevels, baseLevel, strokeSheet,
+                                        sheetItem->boundingRect().topLeft(), levelCount));
+    baseLevel = QImage();
+    strokeSheet = SheetDisplayList();
+}
+
+QVector<QImage> MipmapBuilder::buildLevels(QImage base, SheetDisplayList strokeSheet, QPointF origin, int levels)
+{
+    QPainter painter(&base);
+    painter.setRenderHint(QPainter::Antialiasing);
+    painter.translate(-origin);
+
+    for (const PlacedGlyph &glyph : strokeSheet.glyphs)
+        glyph.svgData->draw(&painter, glyph.rect(), strokeSheet.glyphPen);
+
+    strokeSheet.paintConnections(&painter, QRectF(origin, base.size()));
+    painter.end();
+
+    QVector<QImage> result;
+    result.push_back(base);
+
+    for (int i = 1; i < levels; i++)
+    {
+        const QImage &previous = result.last();
+
+        if (previous.width() < 2 || previous.height() < 2)
+            break;
+
+        result.push_back(previous.scaled(previous.size() / 2, Qt::IgnoreAspectRatio,
+                                         Qt::SmoothTransformation));
+    }
+
+    return result;
+}
+
+void MipmapBuilder::levelsReady()
+{
+    //the sheet was changed while the levels were scaled
+    if (scaledGeneration != generation)
+        return;
+
+    sheetItem->setMipmaps(watcher.result());
+}
@@ -0,0 +1,55 @@
+/*!
+    MipmapBuilder - rasterizes the sheet of SvgView into a chain of
+    images of 1/1, 1/2, 1/4, ... of the scene size.
+
+    While the user zooms or pans, SheetItem draws the nearest level of
+    the chain instead of thousands of SVG glyphs, and SvgView switches
+    back to vector rendering after the interaction stops.
+
+    Glyphs drawn from their strokes, connections and the smaller levels
+    are rendered with QtConcurrent. Glyph renderers belong to the GUI
+    thread, so the few glyphs that have one are drawn there first, in
+    small chunks between events.
+*/
+#ifndef MIPMAPBUILDER_H
+#define MIPMAPBUILDER_H
+
+#include <QtCore/QObject>
+#include <QtCore/QTimer>
+#include <QtCore/QFutureWatcher>
+#include <QtGui/QImage>
+
+#include "sheetitem.h"
+
+class MipmapBuilder : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit MipmapBuilder(QObject *parent = 0);
+    ~MipmapBuilder();
+
+    void start(SheetItem *item, int levels = 4); //!< drops the unfinished chain and starts a new one
+    void cancel();
+
+private:
+    SheetItem *sheetItem;
+    QImage baseLevel;
+    SheetDisplayList strokeSheet; //!< the sheet without glyphs that need their renderers
+    int levelCount;
+    int nextGlyph;
+    int generation; //!< distinguishes chains of different sheets
+    int scaledGeneration; //!< generation of the chain that is being scaled
+    QTimer chunkTimer;
+    QFutureWatcher<QVector<QImage>> watcher;
+
+    void renderLevels(); //!< finishes the full size level and scales it in another thread
+    //! draws strokeSheet over base, which has the glyphs of renderers, and scales it
+    static QVector<QImage> buildLevels(QImage base, SheetDisplayList strokeSheet, QPointF origin, int levels);
+
+private slots:
+    void renderChunk();
+    void levelsReady();
+};
+
+#endif // MIPMAPBUILDER_H
@@ -0,0 +1,42 @@
+#include "missingglyphs.h"
+
+#include <QtCore/QJsonArray>
+
+void MissingGlyphs::merge(const MissingGlyphs &sheetReport, int sheetNumber)
+{
+    for (auto it = sheetReport.counts.constBegin(); it != sheetReport.counts.constEnd(); ++it)
+    {
+        counts[it.key()] += it.value();
+
+        if (!sheets[it.key()].contains(sheetNumber))
+            sheets[it.key()].append(sheetNumber);
+    }
+}
+
+QJsonObject MissingGlyphs::toJson() const
+{
+    QJsonArray characters;
+    int total = 0;
+
+    for (auto it = counts.constBegin(); it != counts.constEnd(); ++it)
+    {
+        QJsonArray sheetNumbers;
+
+        for (int sheet : sheets.value(it.key()))
+            sheetNumbers.append(sheet + 1); //sheets are numbered from one for the user
+
+        QJsonObject character;
+        character.insert("character", QString(it.key()));
+        character.insert("codepoint", it.key().unicode());
+        character.insert("count", it.value());
+        character.insert("sheets", sheetNumbers);
+        characters.append(character);
+        total += it.value();
+    }
+
+    QJsonObject report;
+    report.insert("missing", characters);
+    report.insert("total", total);
+
+    return report;
+}
@@ -0,0 +1,30 @@
+/*!
+    MissingGlyphs - statistics about characters of the text that are
+    missing in the loaded font.
+
+    SheetLayout collects it as a by-product of placing characters on a sheet,
+    so nobody has to scan the text once more. MainWindow merges the reports
+    of all rendered sheets and shows them to the user or saves them as JSON
+    next to the exported files.
+*/
+#ifndef MISSINGGLYPHS_H
+#define MISSINGGLYPHS_H
+
+#include <QtCore/QMap>
+#include <QtCore/QList>
+#include <QtCore/QJsonObject>
+
+struct MissingGlyphs
+{
+    QMap<QChar, int> counts;         //!< how many times each missing character occurs
+    QMap<QChar, QList<int>> sheets;  //!< numbers of sheets where each missing character occurs
+
+    void add(QChar symbol) {counts[symbol]++;}
+    void merge(const MissingGlyphs &sheetReport, int sheetNumber);
+    void clear() {counts.clear(); sheets.clear();}
+    bool isEmpty() const {return counts.isEmpty();}
+    QList<QChar> characters() const {return counts.keys();}
+    QJsonObject toJson() const;
+};
+
+#endif // MISSINGGLYPHS_H
@@ -12,6 +12,12 @@ PreferencesDialog::PreferencesDialog(QWidget *parent) :
             this, SLOT(loadSettingsFromFile()));
     connect(ui->VRadioButton, SIGNAL(toggled(bool)),
             this, SLOT(changeSheetOrientation()));
+    connect(ui->penWidthSpinBox, SIGNAL(valueChanged(double)),
+            this, SLOT(emitPenChanged()));
+    connect(ui->fontColorCheckBox, SIGNAL(toggled(bool)),
+            this, SLOT(emitPenChanged()));
+    connect(ui->roundCheckBox, SIGNAL(toggled(bool)),
+            this, SLOT(emitPenChanged()));
 
     sheetSizeSignalMapper = new QSignalMapper(this);
 
@@ -92,6 +98,16 @@ void PreferencesDialog::loadSettingsToFile()
     settings.setValue("right-margins-indent", QVariant(ui->rightMarginsIndentSpinBox->value()));
     settings.setValue("draw-left-margins", QVariant(ui->leftMarginsCheckBox->isChecked()));
     settings.setValue("draw-right-margins", QVariant(ui->rightMarginsCheckBox->isChecked()));
+    settings.setValue("glyph-atlas-export", QVariant(ui->glyphAtlasCheckBox->isChecked()));
+    settings.setValue("glyph-cache-size", QVariant(ui->glyphCacheSizeSpinBox->value()));
+    settings.setValue("mipmap-navigation", QVariant(ui->mipmapNavigationCheckBox->isChecked()));
+    settings.setValue("prefetch-sheets", QVariant(ui->prefetchSheetsCheckBox->isChecked()));
+    settings.setValue("live-preview", QVariant(ui->livePreviewCheckBox->isChecked()));
+    settings.setValue("continuous-scroll", QVariant(ui->continuousScrollCheckBox->isChecked()));
+    settings.setValue("sheet-cache-size", QVariant(ui->sheetCacheSizeSpinBox->value()));
+    settings.setValue("word-cache-size", QVariant(ui->wordCacheSizeSpinBox->value()));
+    settings.setValue("word-cache-variants", QVariant(ui->wordCacheVariantsSpinBox->value()));
+    settings.setValue("lazy-glyph-loading", QVariant(ui->lazyGlyphLoadingCheckBox->isChecked()));
     settings.endGroup();
 
     emit settingsChanged();
@@ -141,12 +157,23 @@ void PreferencesDialog::loadSettingsFromFile(bool loadDefault)
     ui->leftMarginsCheckBox->setChecked(        settings.value("draw-left-margins", false).toBool());
     ui->leftMarginsIndentSpinBox->setValue(     settings.value("left-margins-indent", 10).toDouble());
     ui->rightMarginsIndentSpinBox->setValue(    settings.value("right-margins-indent", 20).toDouble());
+    ui->glyphAtlasCheckBox->setChecked(         settings.value("glyph-atlas-export", false).toBool());
+    ui->glyphCacheSizeSpinBox->setValue(        settings.value("glyph-cache-size", 256).toInt());
+    ui->mipmapNavigationCheckBox->setChecked(   settings.value("mipmap-navigation", false).toBool());
+    ui->prefetchSheetsCheckBox->setChecked(     settings.value("prefetch-sheets", true).toBool());
+    ui->livePreviewCheckBox->setChecked(        settings.value("live-preview", false).toBool());
+    ui->continuousScrollCheckBox->setChecked(   settings.value("continuous-scroll", false).toBool());
+    ui->sheetCacheSizeSpinBox->setValue(        settings.value("sheet-cache-size", 32).toInt());
+    ui->wordCacheSizeSpinBox->setValue(         settings.value("word-cache-size", 0).toInt());
+    ui->wordCacheVariantsSpinBox->setValue(     settings.value("word-cache-variants", 4).toInt());
+    ui->lazyGlyphLoadingCheckBox->setChecked(   settings.value("lazy-glyph-loading", false).toBool());
     ui->colorButton->setStyleSheet(QString("QPushButton { background-color : %1; border-style: inset;}")
                                            .arg(settings.value("font-color", "#0097ff").toString()));
     ui->markingColorButton->setStyleSheet(QString("QPushButton { background-color : %1; border-style: inset;}")
                                            .arg(settings.value("marking-color", "#a7c0bc").toString()));
     ui->marginsColorButton->setStyleSheet(QString("QPushButton { background-color : %1; border-style: inset;}")
                                            .arg(settings.value("margins-color", "#c67d98").toString()));
+    emitPenChanged(); //the colour button doesn't notify, a cancelled preview is reverted here
 
     settings.endGroup();
 
@@ -243,9 +270,31 @@ bool PreferencesDialog::alternateMargins()
     return ui->alternateMarginsCheckBox->isChecked();
 }
 
+bool PreferencesDialog::prefetchSheets()
+{
+    return ui->prefetchSheetsCheckBox->isChecked();
+}
+
+bool PreferencesDialog::livePreview()
+{
+    return ui->livePreviewCheckBox->isChecked();
+}
+
+int PreferencesDialog::sheetCacheSize()
+{
+    return ui->sheetCacheSizeSpinBox->value();
+}
+
 void PreferencesDialog::on_colorButton_clicked()
 {
     setColor(ui->colorButton);
+    emitPenChanged();
+}
+
+void PreferencesDialog::emitPenChanged()
+{
+    emit penChanged(ui->penWidthSpinBox->value(), ui->colorButton->palette().background().color(),
+                    ui->fontColorCheckBox->isChecked(), ui->roundCheckBox->isChecked());
 }
 
 void PreferencesDialog::on_markingColorButton_clicked()
@@ -29,9 +29,14 @@ public slots:
     void loadSettingsToFile();
     void loadSettingsFromFile(bool loadDefault = false);
     bool alternateMargins();
+    bool prefetchSheets();
+    bool livePreview();
+    int sheetCacheSize(); //!< megabytes
 
 signals:
     void settingsChanged();
+    //! the pen of glyphs was edited, the settings aren't saved yet
+    void penChanged(qreal width, const QColor &color, bool useCustomColor, bool roundLines);
 
 private:
     Ui::PreferencesDialog *ui;
@@ -50,6 +55,7 @@ private slots:
     void setColor(QPushButton * button);
     void changeSheetOrientation();
     void on_colorButton_clicked();
+    void emitPenChanged();
     void on_markingColorButton_clicked();
     void on_markingFitPushButton_clicked();
     void on_DefaultPushButton_clicked();
@@ -0,0 +1,43 @@
+/*!
+    RenderStatistics - cheap counters that SheetLayout fills while laying out
+    a sheet. They are compiled in all builds and printed to the
+    "scribbler.render" logging category, so they can be enabled with
+    QT_LOGGING_RULES="scribbler.render.debug=true".
+
+    PaintStatistics - counters of one frame of SvgView, filled by SheetItem
+    and SvgView. They are shown over the sheet when the paint statistics
+    overlay is switched on.
+*/
+#ifndef RENDERSTATISTICS_H
+#define RENDERSTATISTICS_H
+
+#include <QtCore/QLoggingCategory>
+#include <QtCore/QtGlobal>
+
+Q_DECLARE_LOGGING_CATEGORY(renderLog)
+
+struct RenderStatistics
+{
+    int glyphs = 0;          //!< glyphs placed on the sheet
+    int allocatedItems = 0;  //!< glyph arrays allocated for the sheet
+    int wordCacheHits = 0;   //!< words taken from WordCache
+    int wordCacheMisses = 0; //!< words built for WordCache
+
+    void reset() {*this = RenderStatistics();}
+};
+
+struct PaintStatistics
+{
+    int glyphsPainted = 0;      //!< glyphs drawn from SVG or simplified strokes
+    int glyphsCulled = 0;       //!< glyphs outside of the exposed rectangle
+    int connectionsPainted = 0; //!< paths that connect letters
+    int mipmapsPainted = 0;     //!< sheets drawn from a raster level instead of glyphs
+    qint64 glyphsTime = 0;      //!< nanoseconds
+    qint64 connectionsTime = 0;
+    qint64 backgroundTime = 0;  //!< the paper, marking and borders
+    qint64 frameTime = 0;
+
+    void reset() {*this = PaintStatistics();}
+};
+
+#endif // RENDERSTATISTICS_H
@@ -0,0 +1,166 @@
+#include "renderworker.h"
+
+RenderWorker::RenderWorker(QObject *parent) : QObject(parent)
+{
+    useGlyphAtlas = false;
+    qRegisterMetaType<SheetDisplayList>("SheetDisplayList");
+}
+
+int RenderWorker::newRequest()
+{
+    return latestRequest.fetchAndAddOrdered(1) + 1;
+}
+
+void RenderWorker::preparePrinter(QPrinter *printer)
+{
+    QSettings settings("Settings.ini", QSettings::IniFormat);
+    settings.beginGroup("Settings");
+
+    QSizeF paperSize(settings.value("sheet-width", 210.0).toInt(), settings.value("sheet-height", 297.0).toInt());
+    bool isPortrait = settings.value("is-sheet-orientation-vertical", true).toBool();
+
+    printer->setPaperSize(paperSize, QPrinter::Millimeter);
+    printer->setResolution(settings.value("dpi", 300).toInt());
+    printer->setOrientation(isPortrait ? QPrinter::Portrait : QPrinter::Landscape);
+    printer->setDoubleSidedPrinting(true);
+
+    settings.endGroup();
+}
+
+void RenderWorker::reload()
+{
+    layout.loadSettingsFromFile();
+    glyphAtlas.clear();
+
+    QSettings settings("Settings.ini", QSettings::IniFormat);
+    settings.beginGroup("Settings");
+    useGlyphAtlas = settings.value("glyph-atlas-export").toBool();
+    settings.endGroup();
+}
+
+void RenderWorker::layOutSheet(int request, const QString &text, int number, int begin, bool changedMargins)
+{
+    if (isStale(request))
+        return;
+
+    SheetDisplayList sheet;
+    int end = begin + layout.layOutText(QStringRef(&text, begin, text.length() - begin), changedMargins, sheet);
+    emit sheetReady(request, number, begin, end, sheet);
+}
+
+void RenderWorker::layOutSheetsUntil(int request, const QString &text, int number, int begin, int position,
+                                     bool alternateMargins)
+{
+    for ( ; ; number++)
+    {
+        if (isStale(request))
+            return;
+
+        SheetDisplayList sheet;
+        bool changedMargins = alternateMargins && number % 2;
+        int end = begin + layout.layOutText(QStringRef(&text, begin, text.length() - begin), changedMargins, sheet);
+        emit sheetReady(request, number, begin, end, sheet);
+
+        if (end > position || end >= text.length())
+            return;
+
+        begin = end;
+    }
+}
+
+void RenderWorker::renderThumbnails(int request, const QString &text, int number, int begin, bool alternateMargins,
+                                    int width)
+{
+    QPen strokePen = layout.strokePen();
+
+    for ( ; ; number++)
+    {
+        if (isStale(request))
+            return;
+
+        SheetDisplayList sheet;
+        bool changedMargins = alternateMargins && number % 2;
+        int end = begin + layout.layOutText(QStringRef(&text, begin, text.length() - begin), changedMargins, sheet);
+        emit thumbnailReady(request, number, begin, end, sheet.toThumbnail(width, strokePen));
+
+        if (end >= text.length())
+            return;
+
+        begin = end;
+    }
+}
+
+bool RenderWorker::layOutAll(int request, const QString &text, bool alternateMargins,
+                             const std::function<void(int, bool, const SheetDisplayList &)> &output)
+{
+    int begin = 0;
+
+    for (int number = 0; ; number++)
+    {
+        if (isStale(request))
+            return false;
+
+        SheetDisplayList sheet;
+        bool changedMargins = alternateMargins && number % 2;
+        int end = begin + layout.layOutText(QStringRef(&text, begin, text.length() - begin), changedMargins, sheet);
+        bool isLast = end >= text.length();
+
+        output(number, isLast, sheet);
+        emit sheetReady(request, number, begin, end, sheet);
+
+        if (isLast)
+            return true;
+
+        begin = end;
+    }
+}
+
+void RenderWorker::exportImages(int request, const QString &text, const QString &fileName, bool alternateMargins)
+{
+    int indexOfExtension = fileName.indexOf(QRegularExpression("\\.\\w+$"), 0);
+
+    bool completed = layOutAll(request, text, alternateMargins,
+                               [&](int number, bool isLast, const SheetDisplayList &sheet)
+    {
+        QString currentFileName = fileName;
+
+        if (number > 0 || !isLast) //i.e. there is more than one sheet
+            currentFileName.insert(indexOfExtension, QString("_%1").arg(number));
+
+        sheet.toImage(useGlyphAtlas ? &glyphAtlas : nullptr).save(currentFileName);
+    });
+
+    emit exportFinished(request, completed);
+}
+
+void RenderWorker::exportPdf(int request, const QString &text, const QString &fileName, bool alternateMargins)
+{
+    QPrinter printer(QPrinter::PrinterResolution);
+    printer.setOutputFormat(QPrinter::PdfFormat);
+    printer.setOutputFileName(fileName);
+    preparePrinter(&printer);
+
+    QPainter painter(&printer);
+    painter.setRenderHint(QPainter::Antialiasing);
+
+    if (!printer.isValid())
+    {
+        emit exportFinished(request, false);
+        return;
+    }
+
+    qreal scale = qreal(printer.resolution()) / layout.getDpi();
+
+    bool completed = layOutAll(request, text, alternateMargins,
+                               [&](int number, bool isLast, const SheetDisplayList &sheet)
+    {
+        Q_UNUSED(number);
+        sheet.print(&painter, scale);
+
+        if (!isLast)
+            printer.newPage();
+    });
+
+    painter.end();
+    emit exportFinished(request, completed);
+}
@@ -0,0 +1,73 @@
+/*!
+    RenderWorker - lays sheets out and exports them in a background thread.
+
+    It owns a SheetLayout with its own copy of the font and settings,
+    which is loaded by reload() after the settings or the font are
+    changed in the main window. MainWindow moves the worker to its thread
+    and calls the slots through queued connections; finished sheets are
+    published by sheetReady(). Glyphs of these sheets belong to the font
+    of the worker, SvgView::adoptSheet() replaces them, the glyphs of
+    placed words too, before the sheet is shown or cached, so the GUI
+    never paints with or destroys renderers the worker uses.
+
+    layOutSheetsUntil() serves the live preview: it lays out the edited
+    sheet, and the sheets before it if their beginnings aren't known yet.
+
+    renderThumbnails() lays out sheets to the end of the text and draws
+    them at the size of thumbnails; MainWindow runs it on another worker
+    with a low priority.
+
+    Every job gets a number from newRequest(). A new request makes
+    older ones stale: the worker checks it between sheets and drops
+    a stale job, and MainWindow ignores results of stale jobs.
+*/
+#ifndef RENDERWORKER_H
+#define RENDERWORKER_H
+
+#include <QtCore/QObject>
+#include <QtCore/QAtomicInt>
+#include <functional>
+#include <QtPrintSupport/QPrinter>
+
+#include "sheetlayout.h"
+#include "sheetdisplaylist.h"
+#include "glyphatlas.h"
+
+class RenderWorker : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit RenderWorker(QObject *parent = 0);
+
+    int newRequest(); //!< thread-safe; cancels the running job
+    bool isStale(int request) const {return request != latestRequest.load();}
+    static void preparePrinter(QPrinter *printer); //!< paper size, orientation and resolution of settings
+
+public slots:
+    void reload();
+    void releaseGlyphPack(const QString &fileName) {layout.releaseGlyphPack(fileName);}
+    void layOutSheet(int request, const QString &text, int number, int begin, bool changedMargins);
+    //! lays out sheets from the given one up to the sheet with the character at position
+    void layOutSheetsUntil(int request, const QString &text, int number, int begin, int position, bool alternateMargins);
+    void renderThumbnails(int request, const QString &text, int number, int begin, bool alternateMargins, int width);
+    void exportImages(int request, const QString &text, const QString &fileName, bool alternateMargins);
+    void exportPdf(int request, const QString &text, const QString &fileName, bool alternateMargins);
+
+signals:
+    void sheetReady(int request, int number, int begin, int end, const SheetDisplayList &sheet);
+    void exportFinished(int request, bool completed);
+    void thumbnailReady(int request, int number, int begin, int end, const QImage &image);
+
+private:
+    SheetLayout layout;
+    GlyphAtlas glyphAtlas; //!< without GlyphRasterCache, its files belong to SvgView
+    bool useGlyphAtlas;
+    QAtomicInt latestRequest;
+
+    //! lays out sheets from the first one and passes them to output; returns false if the job became stale
+    bool layOutAll(int request, const QString &text, bool alternateMargins,
+                   const std::function<void(int number, bool isLast, const SheetDisplayList &sheet)> &output);
+};
+
+#endif // RENDERWORKER_H
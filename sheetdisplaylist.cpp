@@ -0,0 +1,220 @@
+#include "sheetdisplaylist.h"
+#include "glyphatlas.h"
+#include "wordcache.h"
+
+#include <QtCore/QtMath>
+
+void SheetDisplayList::clear()
+{
+    glyphs.resize(0); //unlike clear(), it keeps allocated memory for the next sheet
+    words.resize(0);
+    connections.clear();
+    wordConnectionsBegin = 0;
+    connectionRects.clear();
+    missingGlyphs.clear();
+}
+
+void SheetDisplayList::setConnections(const QVector<QPainterPath> &paths, const QVector<QPainterPath> &wordPaths,
+                                      const QPen &pen)
+{
+    connections = paths + wordPaths;
+    wordConnectionsBegin = paths.size();
+    connectionPen = pen;
+    connectionRects.clear();
+
+    qreal halfWidth = pen.widthF() / 2.0;
+
+    for (const QPainterPath &path : connections)
+        connectionRects.push_back(path.controlPointRect().adjusted(-halfWidth, -halfWidth,
+                                                                   halfWidth, halfWidth));
+}
+
+int SheetDisplayList::paintConnections(QPainter *painter, const QRectF &exposedRect) const
+{
+    return paintConnections(painter, exposedRect, 0, connections.size());
+}
+
+int SheetDisplayList::paintConnections(QPainter *painter, const QRectF &exposedRect, int first, int last) const
+{
+    painter->setPen(connectionPen);
+    painter->setBrush(Qt::NoBrush);
+    int painted = 0;
+
+    for (int i = first; i < last; i++)
+        if (exposedRect.intersects(connectionRects.at(i)))
+        {
+            painter->drawPath(connections.at(i));
+            painted++;
+        }
+
+    return painted;
+}
+
+void SheetDisplayList::render(QPainter *painter, GlyphAtlas *atlas, bool useWordImages) const
+{
+    QVector<bool> isWordDrawn(words.size(), false);
+
+    for (int i = 0; i < words.size(); i++)
+    {
+        const PlacedWord &word = words.at(i);
+
+        if (!useWordImages || !isWordIntact(word))
+            continue;
+
+        //the origin of the word is restored from its first glyph, which could be wrapped
+        QPointF origin = glyphs.at(word.firstGlyph).pos - word.variant->glyphs.first().pos;
+        painter->drawImage(origin + word.variant->imageOffset, word.variant->image);
+        isWordDrawn[i] = true;
+    }
+
+    QPainterPath brokenWords; //connections of words that are drawn glyph by glyph
+
+    for (int i = 0; i < glyphs.size(); i++)
+    {
+        const PlacedGlyph &glyph = glyphs.at(i);
+
+        if (!glyph.visible || (glyph.word >= 0 && isWordDrawn.at(glyph.word)))
+            continue;
+
+        if (atlas != nullptr)
+            atlas->draw(painter, glyph, glyphPen);
+        else
+            glyph.svgData->draw(painter, glyph.rect(), glyphPen);
+
+        if (glyph.word >= 0 && i > 0 && glyphs.at(i - 1).word == glyph.word && glyphs.at(i - 1).visible)
+            addConnection(brokenWords, glyphs.at(i - 1), glyph);
+    }
+
+    paintConnections(painter, sheetRect, 0, wordConnectionsBegin);
+
+    if (wordConnectionsBegin < connections.size()) //letters are connected at all
+        painter->drawPath(brokenWords);
+}
+
+void SheetDisplayList::replay(QPainter *painter, GlyphAtlas *atlas, bool useWordImages) const
+{
+    painter->drawPicture(0, 0, paper);
+    render(painter, atlas, useWordImages);
+}
+
+QImage SheetDisplayList::toImage(GlyphAtlas *atlas) const
+{
+    QImage image(sheetRect.size().toSize(), QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::transparent);
+    QPainter painter(&image);
+    painter.setRenderHint(QPainter::Antialiasing);
+    painter.translate(-sheetRect.topLeft());
+    replay(&painter, atlas);
+    return image;
+}
+
+QImage SheetDisplayList::toThumbnail(int width, const QPen &strokePen) const
+{
+    qreal scale = width / sheetRect.width();
+    QImage image(width, qCeil(sheetRect.height() * scale), QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::white);
+    QPainter painter(&image);
+    painter.setRenderHint(QPainter::Antialiasing);
+    painter.scale(scale, scale);
+    painter.translate(-sheetRect.topLeft());
+    painter.drawPicture(0, 0, paper);
+    painter.setPen(strokePen);
+    painter.setBrush(Qt::NoBrush);
+
+    //the coarsest simplified strokes are much finer than a pixel of the thumbnail
+    for (const PlacedGlyph &glyph : glyphs)
+    {
+        if (!glyph.visible)
+            continue;
+
+        if (!glyph.svgData->lodPaths.isEmpty())
+        {
+            if (!strokePen.color().isValid() && painter.pen().color() != glyph.svgData->strokeColor)
+            {
+                QPen pen(strokePen);
+                pen.setColor(glyph.svgData->strokeColor);
+                painter.setPen(pen);
+            }
+
+            painter.translate(glyph.pos);
+            painter.drawPath(glyph.svgData->lodPaths.last());
+            painter.translate(-glyph.pos);
+        }
+        else
+            glyph.svgData->draw(&painter, glyph.rect(), strokePen); //the pen is restored
+    }
+
+    paintConnections(&painter, sheetRect);
+    return image;
+}
+
+void SheetDisplayList::print(QPainter *painter, qreal scale) const
+{
+    painter->save();
+    painter->scale(scale, scale);
+    painter->translate(-sheetRect.topLeft());
+    replay(painter, nullptr, false); //images of words would be rasterized at the dpi of settings
+    painter->restore();
+}
+
+int SheetDisplayList::memoryCost() const
+{
+    //glyph data and images of words belong to the font and WordCache, the paper is shared by all sheets
+    int cost = sizeof(SheetDisplayList) +
+               glyphs.capacity() * sizeof(PlacedGlyph) +
+               words.capacity() * sizeof(PlacedWord) +
+               connectionRects.capacity() * sizeof(QRectF);
+
+    for (const QPainterPath &path : connections)
+        cost += path.elementCount() * sizeof(QPainterPath::Element);
+
+    return cost;
+}
+
+bool SheetDisplayList::isWordIntact(const PlacedWord &word) const
+{
+    const QVector<PlacedGlyph> &variantGlyphs = word.variant->glyphs;
+
+    //dropped when the pen was changed or glyphs weren't adopted, see SvgView::previewPen() and SheetLayout::adopt()
+    if (word.variant->image.isNull())
+        return false;
+
+    if (word.firstGlyph + variantGlyphs.size() > glyphs.size())
+        return false;
+
+    QPointF origin = glyphs.at(word.firstGlyph).pos - variantGlyphs.first().pos;
+
+    for (int i = 0; i < variantGlyphs.size(); i++)
+    {
+        const PlacedGlyph &glyph = glyphs.at(word.firstGlyph + i);
+        QPointF offset = glyph.pos - origin - variantGlyphs.at(i).pos;
+
+        if (!glyph.visible || qAbs(offset.x()) > 0.01 || qAbs(offset.y()) > 0.01)
+            return false;
+    }
+
+    return true;
+}
+
+void SheetDisplayList::addConnection(QPainterPath &path, const PlacedGlyph &previous, const PlacedGlyph &current)
+{
+    QPointF outPoint = previous.pos + previous.svgData->outPoint;
+    QPointF inPoint = current.pos + current.svgData->inPoint;
+
+    //control points continue the stroke of the previous letter and lead into the stroke
+    //of the current one; a tangent that looks back is replaced with the straight line
+    QPointF chord = inPoint - outPoint;
+    qreal handle = qSqrt(chord.x() * chord.x() + chord.y() * chord.y()) / 3.0;
+    QPointF outTangent = previous.svgData->outTangent;
+    QPointF inTangent = current.svgData->inTangent;
+    QPointF outControl = outPoint + chord / 3.0;
+    QPointF inControl = inPoint - chord / 3.0;
+
+    if (QPointF::dotProduct(outTangent, chord) > 0.0)
+        outControl = outPoint + outTangent * handle;
+    if (QPointF::dotProduct(inTangent, chord) > 0.0)
+        inControl = inPoint - inTangent * handle;
+
+    path.moveTo(outPoint);
+    path.cubicTo(outControl, inControl, inPoint);
+}
@@ -0,0 +1,87 @@
+/*!
+    SheetDisplayList - everything that is drawn on a laid out sheet:
+    placed glyphs, words from WordCache, connections of letters and
+    the paper.
+
+    SheetItem keeps the list of the sheet on the screen. SvgView records
+    a copy of it for MainWindow, which replays it to an image, a PDF or
+    a printer at the resolution of the target, or shows it again
+    without laying the text out once more. Thumbnails of the sidebar
+    are drawn from it at their own size. Copies are cheap: glyph data
+    is shared and vectors are implicitly shared.
+
+    Coordinates are pixels of the sheet at the dpi of settings.
+*/
+#ifndef SHEETDISPLAYLIST_H
+#define SHEETDISPLAYLIST_H
+
+#include <QtCore/QVector>
+#include <QtCore/QMetaType>
+#include <QtGui/QImage>
+#include <QtGui/QPainter>
+#include <QtGui/QPainterPath>
+#include <QtGui/QPicture>
+
+#include "svgdata.h"
+#include "missingglyphs.h"
+
+class GlyphAtlas;
+struct WordVariant;
+
+struct PlacedGlyph
+{
+    QSharedPointer<SvgData> svgData;
+    QPointF pos;  //!< top left corner of the image on the sheet
+    bool visible;
+    int word;     //!< index of the PlacedWord the glyph belongs to, or -1
+
+    QRectF rect() const {return QRectF(pos, svgData->size);}
+};
+
+struct PlacedWord
+{
+    QSharedPointer<WordVariant> variant;
+    int firstGlyph; //!< index of its first glyph in SheetDisplayList::glyphs
+};
+
+struct SheetDisplayList
+{
+    QRectF sheetRect;
+    QPicture paper;              //!< marking and margins lines; borders are never recorded
+    bool changedMargins = false; //!< left and right margins are swapped on this sheet
+    QVector<PlacedGlyph> glyphs;
+    QVector<PlacedWord> words;
+    QVector<QPainterPath> connections; //!< connections between words go first, then inside of PlacedWords
+    int wordConnectionsBegin = 0;
+    QVector<QRectF> connectionRects;   //!< bounding rects of connections including the pen width
+    QPen connectionPen;
+    QPen glyphPen;                     //!< strokes of glyphs are drawn with it, see SvgData::draw()
+    MissingGlyphs missingGlyphs;
+
+    void clear(); //!< removes the contents, but keeps the sheet and allocated memory
+    void setConnections(const QVector<QPainterPath> &paths, const QVector<QPainterPath> &wordPaths,
+                        const QPen &pen);
+
+    //! return the number of painted paths
+    int paintConnections(QPainter *painter, const QRectF &exposedRect) const;
+    int paintConnections(QPainter *painter, const QRectF &exposedRect, int first, int last) const;
+
+    //! glyphs and connections; images of cached words (if useWordImages) and the atlas (if it isn't null) replace SVG
+    void render(QPainter *painter, GlyphAtlas *atlas = nullptr, bool useWordImages = true) const;
+    //! the paper under render(); the painter must be scaled to the resolution of the target
+    void replay(QPainter *painter, GlyphAtlas *atlas = nullptr, bool useWordImages = true) const;
+    QImage toImage(GlyphAtlas *atlas = nullptr) const; //!< replay() into an image of the size of the sheet
+    void print(QPainter *painter, qreal scale) const;  //!< replay() of vectors only, for PDF and printers
+    QImage toThumbnail(int width, const QPen &strokePen) const; //!< the sheet drawn at a small size; strokePen as in SheetItem
+
+    int memoryCost() const; //!< approximate bytes owned by this list alone
+
+    bool isWordIntact(const PlacedWord &word) const; //!< glyphs weren't moved or hidden after placing
+
+    //! adds a curve from the end of the stroke of previous to the begin of the stroke of current
+    static void addConnection(QPainterPath &path, const PlacedGlyph &previous, const PlacedGlyph &current);
+};
+
+Q_DECLARE_METATYPE(SheetDisplayList)
+
+#endif // SHEETDISPLAYLIST_H
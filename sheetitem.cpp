@@ -0,0 +1,165 @@
+#include "sheetitem.h"
+
+#include <QtCore/QtMath>
+
+namespace
+{
+const qreal fullFidelityScale = 0.6; //!< from this zoom glyphs are always rendered from SVG
+const qreal maxScreenError = 0.75;   //!< deviation of simplified strokes in pixels of the screen
+}
+
+SheetItem::SheetItem(const QRectF &rect, QGraphicsItem *parent) : QGraphicsItem(parent)
+{
+    sheet.sheetRect = rect;
+    areMipmapsPreferred = false;
+    paintStatistics = nullptr;
+    setFlag(QGraphicsItem::ItemUsesExtendedStyleOption); //we need exposedRect to skip invisible glyphs
+}
+
+void SheetItem::setSheetRect(const QRectF &rect)
+{
+    prepareGeometryChange();
+    sheet.sheetRect = rect;
+}
+
+void SheetItem::clear()
+{
+    sheet.clear();
+    mipmaps.clear();
+}
+
+void SheetItem::setDisplayList(const SheetDisplayList &list)
+{
+    if (list.sheetRect != sheet.sheetRect)
+        prepareGeometryChange();
+
+    sheet = list;
+    mipmaps.clear();
+    update();
+}
+
+void SheetItem::setMipmapsPreferred(bool prefer)
+{
+    if (areMipmapsPreferred == prefer)
+        return;
+
+    areMipmapsPreferred = prefer;
+
+    if (!mipmaps.isEmpty())
+        update();
+}
+
+void SheetItem::paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget)
+{
+    Q_UNUSED(widget);
+
+    QElapsedTimer timer;
+    timer.start();
+
+    if (areMipmapsPreferred && !mipmaps.isEmpty())
+    {
+        paintMipmap(painter, option->exposedRect);
+
+        if (paintStatistics != nullptr)
+        {
+            paintStatistics->mipmapsPainted++;
+            paintStatistics->glyphsTime += timer.nsecsElapsed();
+        }
+
+        return;
+    }
+
+    int lod = levelOfDetail(painter);
+    int painted = 0, culled = 0;
+    painter->setPen(lodPen);
+    painter->setBrush(Qt::NoBrush);
+
+    for (const PlacedGlyph &glyph : sheet.glyphs)
+    {
+        if (!glyph.visible)
+            continue;
+
+        QRectF glyphRect = glyph.rect();
+
+        if (!option->exposedRect.intersects(glyphRect))
+        {
+            culled++;
+            continue;
+        }
+
+        painted++;
+
+        if (lod >= 0 && lod < glyph.svgData->lodPaths.size())
+        {
+            //glyphs keep the colours of their images if the font colour isn't set
+            if (!lodPen.color().isValid() && painter->pen().color() != glyph.svgData->strokeColor)
+            {
+                QPen pen(lodPen);
+                pen.setColor(glyph.svgData->strokeColor);
+                painter->setPen(pen);
+            }
+
+            painter->translate(glyph.pos);
+            painter->drawPath(glyph.svgData->lodPaths.at(lod));
+            painter->translate(-glyph.pos);
+        }
+        else
+            glyph.svgData->draw(painter, glyphRect, sheet.glyphPen); //the pen is restored
+    }
+
+    qint64 glyphsTime = timer.nsecsElapsed();
+    int connections = sheet.paintConnections(painter, option->exposedRect);
+
+    if (paintStatistics == nullptr)
+        return;
+
+    paintStatistics->glyphsPainted += painted;
+    paintStatistics->glyphsCulled += culled;
+    paintStatistics->connectionsPainted += connections;
+    paintStatistics->glyphsTime += glyphsTime;
+    paintStatistics->connectionsTime += timer.nsecsElapsed() - glyphsTime;
+}
+
+qreal SheetItem::lodTolerance(int level)
+{
+    return level == 0 ? 1.0 : 3.0;
+}
+
+int SheetItem::levelOfDetail(const QPainter *painter)
+{
+    const QTransform &transform = painter->worldTransform();
+    qreal scale = qSqrt(transform.m11() * transform.m11() + transform.m12() * transform.m12());
+
+    if (scale >= fullFidelityScale)
+        return -1;
+
+    //the coarsest level whose error is still invisible
+    int level = 0;
+
+    while (level + 1 < lodLevels() && lodTolerance(level + 1) * scale <= maxScreenError)
+        level++;
+
+    return level;
+}
+
+void SheetItem::paintMipmap(QPainter *painter, const QRectF &exposedRect)
+{
+    //the level that has about one pixel per pixel of the viewport
+    const QTransform &transform = painter->worldTransform();
+    qreal scale = qSqrt(transform.m11() * transform.m11() + transform.m12() * transform.m12());
+    int level = scale > 0.0 ? qFloor(qLn(1.0 / scale) / qLn(2.0)) : 0;
+    level = qBound(0, level, mipmaps.size() - 1);
+
+    const QImage &image = mipmaps.at(level);
+    const QRectF &sheetRect = sheet.sheetRect;
+    QRectF target = exposedRect & sheetRect;
+    qreal sx = image.width() / sheetRect.width();
+    qreal sy = image.height() / sheetRect.height();
+    QRectF source((target.x() - sheetRect.x()) * sx, (target.y() - sheetRect.y()) * sy,
+                  target.width() * sx, target.height() * sy);
+
+    painter->save();
+    painter->setRenderHint(QPainter::SmoothPixmapTransform, false); //the level is already close to the screen size
+    painter->drawImage(target, image, source);
+    painter->restore();
+}
@@ -0,0 +1,75 @@
+/*!
+    SheetItem - the only item of SvgView's scene that holds symbols
+    of a sheet.
+
+    Instead of thousands of QGraphicsSvgItems it owns a SheetDisplayList
+    and paints all of its glyphs in one paint() call. Glyphs that are
+    outside of the exposed rectangle are skipped, so zoom and pan
+    of a dense sheet don't paint the whole sheet every time.
+
+    Lines that connect letters are stored as one path per text line
+    and are painted with a single pen over the glyphs.
+
+    While the view is zoomed or panned, the item can draw the nearest
+    level of a raster copy of the sheet made by MipmapBuilder.
+
+    When the sheet is zoomed out, glyphs that have simplified strokes
+    (SvgData::lodPaths) are drawn as polylines with the pen of strokes
+    instead of their full strokes or SVG. Export paints the sheet at
+    full scale and is unaffected.
+
+    Every paint() adds its counters and timings to the PaintStatistics
+    of the view, if it's set.
+*/
+#ifndef SHEETITEM_H
+#define SHEETITEM_H
+
+#include <QtCore/QElapsedTimer>
+#include <QtWidgets/QGraphicsItem>
+#include <QtWidgets/QStyleOptionGraphicsItem>
+#include <QtGui/QPainter>
+
+#include "sheetdisplaylist.h"
+#include "renderstatistics.h"
+
+class SheetItem : public QGraphicsItem
+{
+public:
+    explicit SheetItem(const QRectF &rect, QGraphicsItem *parent = 0);
+
+    QRectF boundingRect() const {return sheet.sheetRect;}
+    void setSheetRect(const QRectF &rect);
+    void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget = 0);
+
+    void clear();
+
+    QVector<PlacedGlyph> & glyphs() {return sheet.glyphs;}
+    const QVector<PlacedGlyph> & glyphs() const {return sheet.glyphs;}
+    QVector<PlacedWord> & words() {return sheet.words;}
+    const QVector<PlacedWord> & words() const {return sheet.words;}
+    void setConnections(const QVector<QPainterPath> &paths, const QVector<QPainterPath> &wordPaths,
+                        const QPen &pen) {sheet.setConnections(paths, wordPaths, pen);}
+
+    const SheetDisplayList & displayList() const {return sheet;}
+    void setDisplayList(const SheetDisplayList &list); //!< shows a recorded sheet
+
+    void setLodPen(const QPen &pen) {lodPen = pen;}
+    static int lodLevels() {return 2;}
+    static qreal lodTolerance(int level); //!< in scene units, i.e. output pixels
+
+    void setMipmaps(const QVector<QImage> &levels) {mipmaps = levels;}
+    void setMipmapsPreferred(bool prefer); //!< draw raster levels instead of glyphs if they are ready
+    void setPaintStatistics(PaintStatistics *statistics) {paintStatistics = statistics;}
+
+private:
+    SheetDisplayList sheet;
+    QPen lodPen;
+    QVector<QImage> mipmaps; //!< the sheet in 1/1, 1/2, 1/4, ... of its size
+    bool areMipmapsPreferred;
+    PaintStatistics *paintStatistics;
+
+    void paintMipmap(QPainter *painter, const QRectF &exposedRect);
+    static int levelOfDetail(const QPainter *painter); //!< -1 means full fidelity
+};
+
+#endif // SHEETITEM_H
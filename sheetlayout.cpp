@@ -0,0 +1,1325 @@
+#include "sheetlayout.h"
+#include "sheetitem.h"
+
+SheetLayout::SheetLayout()
+{
+    sheet = nullptr;
+    itemsToRemove = 0;
+    changeMargins = false;
+    isPaperPictureValid[0] = isPaperPictureValid[1] = false;
+    fontCoverage.resize(0x10000);
+    preparedSymbols.resize(0x10000);
+    lazyGlyphs = false;
+    penWidth = 0.0;
+    useCustomFontColor = roundLines = false;
+}
+
+int SheetLayout::layOutText(const QStringRef &text, bool changedMargins, SheetDisplayList &result)
+{
+    sheet = &result;
+    changeMargins = changedMargins;
+    prepareToLayOut();
+    loadHyphenRules();
+    prepareGlyphs(text.left(sheetCapacity()));
+    int endOfSheet = 0;
+    int glyphsCapacity = result.glyphs.capacity();
+
+    //Sequentially add the symbols to the sheet
+    for (int currentSymbolNumber = 0; currentSymbolNumber < text.length(); currentSymbolNumber++)
+    {
+        QChar symbol = text.at(currentSymbolNumber);
+        randomizeLetterSpacing();
+        prepareGlyph(symbol); //in case the pre-scan didn't reach it
+
+        if (!fontCoverage.testBit(symbol.unicode()))
+        {
+            if (!symbol.isSpace())
+                missingGlyphs.add(symbol);
+
+            processUnknownSymbol(symbol);
+            endOfSheet++;
+
+            if (cursor.x() > currentMarginsRect.bottomRight().x() - (fontSize + currentLetterSpacing) * dpmm)
+            {
+                cursorToNewLine();
+                storedWordItems.push_back(QVector<int>());
+                storedSymbolData.push_back(QVector<SymbolData>());
+            }
+
+            if (cursor.y() > currentMarginsRect.bottomRight().y() - fontSize * dpmm)
+                break;
+
+            continue;
+        }
+
+        //a word from the cache is placed at once
+        if (wordCache.isEnabled() && symbol.isLetter() &&
+                (currentSymbolNumber == 0 || !text.at(currentSymbolNumber - 1).isLetter()))
+        {
+            int wordLength = placeCachedWord(text, currentSymbolNumber);
+
+            if (wordLength > 0)
+            {
+                currentSymbolNumber += wordLength - 1;
+                endOfSheet += wordLength;
+                continue;
+            }
+        }
+
+        QList<QSharedPointer<SvgData>> variants = font.values(symbol);
+        QSharedPointer<SvgData> data = variants.at(qrand() % variants.size());
+        symbolData = data->symbolData;
+
+        symbolBoundingSize = data->size;
+        qreal symbolWidth = symbolBoundingSize.width() * symbolData.limits.width();
+
+        preventGoingBeyondRightMargin(symbolWidth, text, currentSymbolNumber);
+
+        //rendering stops by the end of sheet
+        if (cursor.y() > currentMarginsRect.bottomRight().y() - fontSize * dpmm)
+            break;
+
+        QPointF symbolItemPos = cursor;
+        symbolItemPos.rx() -= symbolBoundingSize.width() * symbolData.limits.left();
+        symbolItemPos.ry() -= symbolBoundingSize.height() * symbolData.limits.top();
+        symbolItemPos += symbolPositionRandomValue();
+        result.glyphs.push_back({data, symbolItemPos, true, -1});
+
+        previousSymbolCursor = cursor;
+        previousSymbolData = symbolData;
+        previousSymbolWidth = symbolWidth;
+        cursor.rx() += symbolWidth + currentLetterSpacing * dpmm;
+        endOfSheet++;
+
+        if (symbol.isLetter())
+        {
+            storedSymbolData.last().push_back(symbolData);
+            storedWordItems.last().push_back(result.glyphs.size() - 1);
+        }
+        else
+        {
+            storedWordItems.push_back(QVector<int>());
+            storedSymbolData.push_back(QVector<SymbolData>());
+        }
+
+    }
+
+    removeLastSymbols();
+    endOfSheet -= itemsToRemove;
+    connectLetters();
+    result.paper = paperPictures[changeMargins ? 1 : 0];
+    result.glyphPen = strokePen();
+    result.changedMargins = changeMargins;
+    result.missingGlyphs = missingGlyphs;
+    sheet = nullptr;
+
+    statistics.glyphs = result.glyphs.size();
+    if (result.glyphs.capacity() > glyphsCapacity)
+        statistics.allocatedItems++;
+
+    qCDebug(renderLog) << "sheet laid out:" << statistics.glyphs << "glyphs,"
+                       << statistics.allocatedItems << "allocations";
+
+    if (wordCache.isEnabled())
+        qCDebug(renderLog) << "word cache:" << statistics.wordCacheHits << "hits,"
+                           << statistics.wordCacheMisses << "misses on the sheet,"
+                           << qRound(wordCache.hitRate() * 100) << "% hit rate in total";
+
+    return endOfSheet;
+}
+
+int SheetLayout::placeCachedWord(const QStringRef &text, int wordBegin)
+{
+    int wordEnd = wordBegin;
+
+    while (wordEnd < text.size() && text.at(wordEnd).isLetter())
+    {
+        prepareGlyph(text.at(wordEnd));
+
+        if (!fontCoverage.testBit(text.at(wordEnd).unicode()))
+            return 0;
+
+        wordEnd++;
+    }
+
+    if (wordEnd - wordBegin < 2)
+        return 0;
+
+    QString word = text.mid(wordBegin, wordEnd - wordBegin).toString();
+    int variant = qrand() % wordCache.variantsPerWord();
+    QSharedPointer<WordVariant> data = wordCache.find(word, variant);
+
+    if (data.isNull())
+    {
+        data = buildWordVariant(word, variant);
+        wordCache.insert(word, variant, data);
+        statistics.wordCacheMisses++;
+    }
+    else
+        statistics.wordCacheHits++;
+
+    //words that don't fit are placed letter by letter, so they can be wrapped or hyphenated
+    QPointF origin(qRound(cursor.x()), qRound(cursor.y())); //the image is copied to whole pixels
+
+    if (origin.x() + data->width > currentMarginsRect.right() ||
+            cursor.y() > currentMarginsRect.bottomRight().y() - fontSize * dpmm)
+        return 0;
+
+    QVector<PlacedGlyph> &glyphs = sheet->glyphs;
+    int wordIndex = sheet->words.size();
+    sheet->words.push_back({data, glyphs.size()});
+
+    for (const PlacedGlyph &glyph : data->glyphs)
+    {
+        glyphs.push_back({glyph.svgData, origin + glyph.pos, true, wordIndex});
+        storedSymbolData.last().push_back(glyph.svgData->symbolData);
+        storedWordItems.last().push_back(glyphs.size() - 1);
+    }
+
+    symbolData = data->glyphs.last().svgData->symbolData;
+    previousSymbolData = symbolData;
+    previousSymbolCursor = QPointF(origin.x() + data->lastCursor.x(), cursor.y());
+    previousSymbolWidth = data->lastWidth;
+    cursor.rx() = origin.x() + data->advance;
+
+    return wordEnd - wordBegin;
+}
+
+QSharedPointer<WordVariant> SheetLayout::buildWordVariant(const QString &word, int variant)
+{
+    QSharedPointer<WordVariant> result(new WordVariant);
+
+    //own generator, so the variant looks the same whenever it's built
+    std::minstd_rand random(qHash(word) ^ (uint(variant) * 2654435761u) ^ uint(seed));
+    QPointF wordCursor(0.0, 0.0);
+
+    for (const QChar &letter : word)
+    {
+        QList<QSharedPointer<SvgData>> variants = font.values(letter);
+        QSharedPointer<SvgData> data = variants.at(random() % variants.size());
+        const QRectF &limits = data->symbolData.limits;
+        qreal symbolWidth = data->size.width() * limits.width();
+
+        //the same randomization as for single symbols, see symbolPositionRandomValue()
+        QPointF pos = wordCursor - QPointF(data->size.width() * limits.left(),
+                                           data->size.height() * limits.top());
+
+        if (symbolJumpRandomEnabled && symbolJumpRandomValue != 0)
+        {
+            qreal jump = random() % uint(symbolJumpRandomValue * dpmm);
+            pos.ry() += random() % 2 ? -jump : jump;
+        }
+
+        PlacedGlyph glyph = {data, pos, true, -1};
+
+        if (connectingLetters && !result->glyphs.isEmpty())
+            SheetDisplayList::addConnection(result->connections, result->glyphs.last(), glyph);
+
+        result->glyphs.push_back(glyph);
+        result->lastCursor = wordCursor;
+        result->lastWidth = symbolWidth;
+        result->width = wordCursor.x() + symbolWidth;
+
+        qreal spacing = letterSpacing;
+
+        if (letterSpacingRandomEnabled && letterSpacingRandomValue != 0)
+        {
+            qreal jump = random() % uint(letterSpacingRandomValue * dpmm);
+            spacing += random() % 2 ? -jump : jump;
+        }
+
+        wordCursor.rx() += symbolWidth + spacing * dpmm;
+    }
+
+    result->advance = wordCursor.x();
+
+    //rasterize glyphs and connections at the output dpi
+    QPen pen = connectionPen();
+    qreal halfWidth = pen.widthF() / 2.0;
+    QRectF bounds = result->connections.controlPointRect().adjusted(-halfWidth, -halfWidth,
+                                                                   halfWidth, halfWidth);
+
+    for (const PlacedGlyph &glyph : result->glyphs)
+        bounds |= glyph.rect();
+
+    result->imageOffset = QPoint(qFloor(bounds.left()), qFloor(bounds.top()));
+    result->image = QImage(qCeil(bounds.right()) - result->imageOffset.x(),
+                           qCeil(bounds.bottom()) - result->imageOffset.y(),
+                           QImage::Format_ARGB32_Premultiplied);
+    result->image.fill(Qt::transparent);
+
+    QPainter painter(&result->image);
+    painter.setRenderHint(QPainter::Antialiasing);
+    painter.translate(-result->imageOffset);
+
+    QPen glyphPen = strokePen();
+
+    for (const PlacedGlyph &glyph : result->glyphs)
+        glyph.svgData->draw(&painter, glyph.rect(), glyphPen);
+
+    painter.setPen(pen);
+    painter.setBrush(Qt::NoBrush);
+    painter.drawPath(result->connections);
+
+    return result;
+}
+
+void SheetLayout::removeLastSymbols()
+{
+    uint itemsCount = sheet->glyphs.size();
+
+    if (itemsCount < itemsToRemove)
+        return;
+
+    for (uint i = 0; i < itemsToRemove; i++)
+    {
+        while (storedSymbolData.last().isEmpty())
+            storedSymbolData.removeLast();
+        while (storedWordItems.last().isEmpty())
+            storedWordItems.removeLast();
+
+        sheet->glyphs[storedWordItems.last().last()].visible = false;
+        storedSymbolData.last().removeLast();
+        storedWordItems.last().removeLast();
+    }
+}
+
+void SheetLayout::prepareToLayOut()
+{
+    statistics.reset();
+    sheet->clear();
+    storedSymbolData.clear();
+    storedWordItems.clear();
+    storedWordItems.push_back(QVector<int>());
+    storedSymbolData.push_back(QVector<SymbolData>());
+    itemsToRemove = 0;
+    missingGlyphs.clear();
+
+    currentMarginsRect = changedVerticalMargins();
+
+    sheet->sheetRect = sheetRect;
+    updatePaperPicture();
+
+    if (useSeed)
+        qsrand(seed);
+    else
+        qsrand(QTime::currentTime().msec());
+
+    randomizeMargins();
+    cursor = QPointF(currentMarginsRect.x(), currentMarginsRect.y());
+}
+
+bool SheetLayout::preventGoingBeyondRightMargin(qreal symbolWidth, QStringRef text, int currentSymbolIndex)
+{
+    if (cursor.x() > (currentMarginsRect.x() + currentMarginsRect.width() - symbolWidth))
+    {
+        bool hyphenateHappened = hyphenate(text, currentSymbolIndex);
+        bool wrapWordHappened = false;
+
+        if (!hyphenateHappened)
+            wrapWordHappened = wrapWords(text, currentSymbolIndex);
+
+        if (!hyphenateHappened && !wrapWordHappened &&
+                !text.at(currentSymbolIndex).isPunct())
+        {
+            cursorToNewLine();
+            storedWordItems.push_back(QVector<int>());
+            storedSymbolData.push_back(QVector<SymbolData>());
+        }
+
+        return true;
+    }
+
+    return false;
+}
+
+bool SheetLayout::wrapWords(QStringRef text, int currentSymbolIndex)
+{
+    int previousSymbolIndex = currentSymbolIndex - 1;
+
+    if (!wordWrap ||
+            previousSymbolIndex < 0 || previousSymbolIndex >= text.size() ||
+            !(text.at(currentSymbolIndex).isLetterOrNumber() || text.at(currentSymbolIndex).isPunct()) ||
+            !(text.at(previousSymbolIndex).isLetterOrNumber() || text.at(previousSymbolIndex).isPunct()))
+        return false;
+
+    //wrap all the last letters
+    int lastNonLetter = text.toString().lastIndexOf(QRegularExpression("[^\\p{L}]"), currentSymbolIndex);
+    int symbolsToWrap = currentSymbolIndex - lastNonLetter - 1;
+
+    if (wrapLastSymbols(symbolsToWrap))
+    {
+        cursor.rx() = previousSymbolCursor.x() + previousSymbolWidth;
+        cursor.ry() += (fontSize + lineSpacing) * dpmm;
+
+        if (cursor.y() > currentMarginsRect.bottomRight().y() - (lineSpacing + fontSize) * dpmm)
+            itemsToRemove = symbolsToWrap;
+
+        return true;
+    }
+
+    return false;
+}
+
+bool SheetLayout::hyphenate(QStringRef text, int currentSymbolIndex)
+{
+    int previousSymbolIndex = currentSymbolIndex - 1;
+
+    if (!hyphenateWords || previousSymbolIndex < 0 ||
+            previousSymbolIndex >= text.size() ||
+            !text.at(currentSymbolIndex).isLetterOrNumber() ||
+            !text.at(previousSymbolIndex).isLetterOrNumber() ||
+            cursor.y() - previousSymbolCursor.y() > 0.0000001)
+        return false;
+
+    //find word boundary
+    int lastNonLetter = text.toString().lastIndexOf(QRegularExpression("[^\\p{L}]"), currentSymbolIndex);
+    int nextNonLetter = text.toString().indexOf(QRegularExpression("[^\\p{L}]"), currentSymbolIndex);
+    QString word;
+
+    //select a word
+    if (nextNonLetter > 0)
+        word = text.mid(lastNonLetter + 1, nextNonLetter - lastNonLetter).toString();
+    else
+        word = text.mid(lastNonLetter + 1, text.size() - 1).toString();
+
+    QString hypher = "\\1-\\2";
+    QString hyphenWord = word;
+
+    //divide word into syllables with hyphens
+    for (QRegularExpression &rule : hyphenRules)
+        hyphenWord.replace(rule, hypher);
+
+    int currentSymbolInWord = currentSymbolIndex - lastNonLetter - 1;
+
+    //find new position of current letter
+    for (int i = 0; i <= currentSymbolInWord && currentSymbolInWord < hyphenWord.size(); i++)
+        if (hyphenWord.at(i) == '-')
+            currentSymbolInWord++;
+
+    //find hyphen, which is nearest to current letter
+    qreal indexOfLastHyphen = hyphenWord.lastIndexOf('-', currentSymbolInWord);
+    qreal symbolsToWrap = currentSymbolInWord - indexOfLastHyphen - 1;
+
+    //generate hyphens item and hyphenate
+    if (indexOfLastHyphen > 0 && symbolsToWrap >= 0)
+    {
+        PlacedGlyph hyphen = generateHyphen(symbolsToWrap);
+
+        if (!wrapLastSymbols(symbolsToWrap))
+        {
+            randomizeMargins();
+            previousSymbolCursor.rx() = currentMarginsRect.x() - previousSymbolWidth;
+            previousSymbolCursor.ry() += (fontSize + lineSpacing) * dpmm;
+            storedWordItems.push_back(QVector<int>());
+            storedSymbolData.push_back(QVector<SymbolData>());
+        }
+
+        if (!hyphen.svgData.isNull())
+            sheet->glyphs.push_back(hyphen);
+    }
+    else
+        return false;
+
+    cursor.rx() = previousSymbolCursor.x() + previousSymbolWidth;
+    cursor.ry() = previousSymbolCursor.y();
+
+    if (cursor.y() > currentMarginsRect.bottomRight().y() - (lineSpacing + fontSize) * dpmm)
+        itemsToRemove = symbolsToWrap;
+
+    return true;
+}
+
+bool SheetLayout::wrapLastSymbols(int symbolsToWrap)
+{
+    QVector<PlacedGlyph> &glyphs = sheet->glyphs;
+
+    if (symbolsToWrap <= 0 || symbolsToWrap > glyphs.size())
+        return false;
+
+    //find the first item to wrap and it's position
+    int itemsCount = glyphs.size();
+    int itemsToWrap = symbolsToWrap; //TODO: consider missing items
+    const PlacedGlyph &firstItemToWrap = glyphs.at(itemsCount - itemsToWrap);
+    qreal firstWrapItemPosX = firstItemToWrap.pos.x();
+
+    /*if (firstWrapItemPosX == currentMarginsRect.x())
+        return false;*/
+
+    randomizeMargins();
+    //this is how much you need to move symbols to the left
+    qreal leftOffset = firstWrapItemPosX - currentMarginsRect.x();
+
+    if (storedSymbolData.last().size() - symbolsToWrap >= 0) //TODO: consider missing items and get rid of this check
+    {
+        SymbolData firstItemToWrapData = storedSymbolData.last().at(storedSymbolData.last().size() - symbolsToWrap);
+        leftOffset += firstItemToWrap.svgData->size.width() * firstItemToWrapData.limits.left();
+    }
+
+    previousSymbolCursor.rx() -= leftOffset;
+    previousSymbolCursor.ry() += (fontSize + lineSpacing) * dpmm;
+    storedWordItems.push_back(QVector<int>());
+    storedSymbolData.push_back(QVector<SymbolData>());
+
+    //transfer symbols in a new column to half of
+    //the wrapped word were not connected with the line
+    for (int i = itemsToWrap; i > 0; i--)
+    {
+        int size = storedWordItems.size();
+        int wordSize = storedWordItems.at(size - 2).size();
+
+        if (wordSize <= i)
+            break;
+
+        storedWordItems.last().push_back(storedWordItems[size - 2].takeAt(wordSize - i));
+        storedSymbolData.last().push_back(storedSymbolData[size - 2].takeAt(wordSize - i));
+    }
+
+    //wrap items
+    for (int i = itemsToWrap; i > 0; i--)
+    {
+        QPointF &pos = glyphs[itemsCount - i].pos;
+        pos.rx() -= leftOffset;
+        pos.ry() += (fontSize + lineSpacing) * dpmm;
+    }
+
+    return true;
+}
+
+PlacedGlyph SheetLayout::generateHyphen(int symbolsToWrap)
+{
+    PlacedGlyph hyphen = {QSharedPointer<SvgData>(), QPointF(), true, -1};
+    const QVector<PlacedGlyph> &glyphs = sheet->glyphs;
+
+    prepareGlyph('-');
+
+    if (!fontCoverage.testBit('-'))
+        return hyphen;
+
+    symbolsToWrap++;
+
+    if (symbolsToWrap <= 0)
+        return hyphen;
+
+    //prepare hyphens item
+    QList<QSharedPointer<SvgData>> variants = font.values('-');
+    QSharedPointer<SvgData> data = variants.at(qrand() % variants.size());
+
+    if (symbolsToWrap > glyphs.size())
+        return hyphen;
+
+    SymbolData hyphenData = data->symbolData;
+
+    //calculate hyphens position
+    QSizeF hyphenBoundingSize = data->size;
+    const PlacedGlyph &nearestLetter = glyphs.at(glyphs.size() - symbolsToWrap);
+    QPointF hyphenPos = cursor;
+    hyphenPos.ry() -= hyphenBoundingSize.height() * hyphenData.limits.top();
+    hyphenPos.rx() = nearestLetter.pos.x() + nearestLetter.svgData->size.width();
+
+    if (storedSymbolData.last().size() - symbolsToWrap >= 0) //TODO: consider missing items and get rid of this check
+    {
+        SymbolData nearestLetterData = storedSymbolData.last().at(storedSymbolData.last().size() - symbolsToWrap);
+        hyphenPos.rx() -= nearestLetter.svgData->size.width() * (1.0 - nearestLetterData.limits.right());
+    }
+
+    hyphen.svgData = data;
+    hyphen.pos = hyphenPos;
+
+    return hyphen;
+}
+
+void SheetLayout::connectLetters()
+{
+    if (!connectingLetters)
+        return;
+
+    const QVector<PlacedGlyph> &glyphs = sheet->glyphs;
+    qreal lineHeight = (fontSize + lineSpacing) * dpmm;
+    QMap<int, QPainterPath> lines; //connections of every text line are collected in one path
+    QMap<int, QPainterPath> wordLines; //the same for connections inside of cached words
+
+    for (int currentWord = 0; currentWord < storedWordItems.size(); currentWord++)
+    {
+        for (int currentSymbol = 1; currentSymbol < storedWordItems.at(currentWord).size(); currentSymbol++)
+        {
+            const PlacedGlyph &currentLetter = glyphs.at(storedWordItems.at(currentWord).at(currentSymbol));
+            const PlacedGlyph &previousLetter = glyphs.at(storedWordItems.at(currentWord).at(currentSymbol - 1));
+
+            int line = qFloor((previousLetter.pos.y() + previousLetter.svgData->outPoint.y()) / lineHeight);
+            bool isInCachedWord = previousLetter.word >= 0 && previousLetter.word == currentLetter.word;
+
+            SheetDisplayList::addConnection(isInCachedWord ? wordLines[line] : lines[line],
+                                     previousLetter, currentLetter);
+        }
+    }
+
+    sheet->setConnections(lines.values().toVector(), wordLines.values().toVector(), connectionPen());
+}
+
+QPen SheetLayout::connectionPen() const
+{
+    QPen pen(fontColor);
+    pen.setWidth(penWidth * dpmm);
+    pen.setCapStyle(Qt::RoundCap);
+
+    return pen;
+}
+
+QPen SheetLayout::strokePen() const
+{
+    QPen pen(useCustomFontColor ? fontColor : QColor(), penWidth * dpmm);
+    pen.setCapStyle(roundLines ? Qt::RoundCap : Qt::FlatCap);
+    pen.setJoinStyle(roundLines ? Qt::RoundJoin : Qt::MiterJoin);
+
+    return pen;
+}
+
+bool SheetLayout::setPen(qreal width, const QColor &color, bool useCustomColor, bool round)
+{
+    if (penWidth == width && fontColor == color && useCustomFontColor == useCustomColor && roundLines == round)
+        return false;
+
+    penWidth = width;
+    fontColor = color;
+    useCustomFontColor = useCustomColor;
+    roundLines = round;
+    applyStyle();
+
+    return true;
+}
+
+void SheetLayout::processUnknownSymbol(const QChar &symbol)
+{
+    switch (symbol.toLatin1())
+    {
+    case '\t':
+        cursor.rx() += wordSpacing * dpmm * spacesInTab - currentLetterSpacing * dpmm;
+        break;
+
+    case '\n':
+        cursorToNewLine();
+        break;
+
+    case ' ':
+        cursor.rx() += (wordSpacing - currentLetterSpacing) * dpmm;
+        break;
+
+    default:
+        cursor.rx() += (fontSize + currentLetterSpacing) * dpmm;
+        break;
+    }
+
+    storedWordItems.push_back(QVector<int>());
+    storedSymbolData.push_back(QVector<SymbolData>());
+}
+
+bool SheetLayout::loadFont(QString fontpath)
+{
+    if (fontpath.isEmpty())
+    {
+        QSettings settings("Settings.ini", QSettings::IniFormat);
+        settings.beginGroup("Settings");
+        fontpath = settings.value("last-used-font", QString()).toString();
+        settings.endGroup();
+    }
+
+    if (fontpath.isEmpty())
+        return false;
+
+    QElapsedTimer timer;
+    timer.start();
+    QStringList svgFiles;
+    QVector<QPair<QChar, SymbolData>> symbols;
+
+    if (GlyphPack::isGlyphPack(fontpath))
+    {
+        //everything is in the mapped file, only the records are copied
+        if (!glyphPack.open(fontpath))
+            return false;
+
+        for (int i = 0; i < glyphPack.variantCount(); i++)
+        {
+            GlyphPack::Variant variant = glyphPack.variant(i);
+            symbols.push_back(qMakePair(variant.symbol, variant.symbolData));
+        }
+    }
+    else
+    {
+        glyphPack.close();
+        QSettings fontSettings(fontpath, QSettings::IniFormat);
+        fontSettings.beginGroup("Font");
+        fontSettings.setIniCodec(QTextCodec::codecForName("UTF-8"));
+
+        if (fontSettings.allKeys().size() == 0)
+        {
+            fontSettings.endGroup();
+            return false;
+        }
+
+        QString fontDirectory = QFileInfo(fontpath).path() + '/';
+
+        //load the data of fontSymbols except the data for capital (uppercase) letters
+        for (const QString &key : fontSettings.childKeys())
+            for (SymbolData symbolData : fontSettings.value(key).value<QList<SymbolData>>())
+            {
+                symbolData.fileName = fontDirectory + symbolData.fileName;
+                if (key == "slash")
+                    symbols.push_back(qMakePair(QChar('/'), symbolData));
+                else if (key == "backslash")
+                    symbols.push_back(qMakePair(QChar('\\'), symbolData));
+                else
+                    symbols.push_back(qMakePair(key.at(0), symbolData));
+            }
+
+        //Load uppercase letters.
+        //It's a dirty hack, which helps to distinguish uppercase and lowercase
+        //letters on a freaking case-insensetive Windows
+        fontSettings.beginGroup("UpperCase");
+        for (const QString &key : fontSettings.childKeys())
+            for (SymbolData symbolData : fontSettings.value(key).value<QList<SymbolData>>())
+            {
+                symbolData.fileName = fontDirectory + symbolData.fileName;
+                symbols.push_back(qMakePair(key.at(0), symbolData));
+            }
+
+        fontSettings.endGroup();
+        fontSettings.endGroup();
+
+        //images are separate files here; in a pack the stamp of the pack covers them
+        for (const QPair<QChar, SymbolData> &symbol : symbols)
+            svgFiles << symbol.second.fileName;
+    }
+
+    //clear the loaded font; placed glyphs keep their data until the next render
+    loadedFontParameters = fontParameters(fontpath);
+    font.clear();
+    fontGlyphs.clear();
+    fontCoverage.fill(false);
+    wordCache.clear();
+    fontSymbols = symbols;
+    symbolVariants.clear();
+    preparedSymbols.fill(false);
+
+    //only the index of the font is loaded, glyphs are prepared when they are placed first
+    if (lazyGlyphs)
+    {
+        fontGlyphs.resize(fontSymbols.size());
+
+        for (int i = 0; i < fontSymbols.size(); i++)
+        {
+            symbolVariants.insert(fontSymbols.at(i).first, i);
+            fontCoverage.setBit(fontSymbols.at(i).first.unicode());
+        }
+
+        qCDebug(renderLog) << "font indexed:" << fontSymbols.size() << "variants in" << timer.elapsed() << "ms";
+        return true;
+    }
+
+    //everything that prepareSymbol() takes from settings
+    QByteArray parameters;
+    QDataStream stream(&parameters, QIODevice::WriteOnly);
+    stream << dpi << fontSize << SheetItem::lodLevels();
+
+    QByteArray key = FontCache::fontKey(fontpath, svgFiles, parameters);
+    QVector<FontCache::Glyph> compiledGlyphs;
+
+    if (fontCache.read(key, compiledGlyphs))
+    {
+        for (const FontCache::Glyph &glyph : compiledGlyphs)
+            addGlyph(glyph.key, glyph.data, fontGlyphs.size());
+
+        applyStyle(); //the cache keeps glyphs without the pen
+
+        qCDebug(renderLog) << "font loaded from cache:" << fontGlyphs.size() << "glyphs in"
+                           << timer.elapsed() << "ms";
+        return true;
+    }
+
+    QVector<int> indices(fontSymbols.size());
+    std::iota(indices.begin(), indices.end(), 0);
+    QFuture<FontCache::Glyph> glyphs = prepareSymbols(indices);
+
+    //results are taken in the order of the font, so ids of glyphs don't depend on timing
+    for (int i = 0; i < fontSymbols.size(); i++)
+    {
+        FontCache::Glyph glyph = glyphs.resultAt(i);
+
+        if (!glyph.data.isNull()) //the file isn't missing or broken
+        {
+            addGlyph(glyph.key, glyph.data, fontGlyphs.size());
+            compiledGlyphs.push_back(glyph);
+        }
+
+        if (fontProgress)
+            fontProgress(i + 1, fontSymbols.size());
+    }
+
+    fontCache.write(key, compiledGlyphs);
+    qCDebug(renderLog) << "font compiled:" << fontGlyphs.size() << "glyphs in" << timer.elapsed() << "ms";
+
+    return true;
+}
+
+void SheetLayout::releaseGlyphPack(const QString &fileName)
+{
+    //prepared glyphs are copies, only the glyphs that aren't prepared yet are lost
+    if (glyphPack.isOpen() && QFileInfo(glyphPack.fileName()) == QFileInfo(fileName))
+        glyphPack.close();
+}
+
+QFuture<FontCache::Glyph> SheetLayout::prepareSymbols(const QVector<int> &indices) const
+{
+    //glyphs are independent, so they are prepared by the thread pool; renderers move to this thread
+    QThread *layoutThread = QThread::currentThread();
+    std::function<FontCache::Glyph(int)> prepare = [this, layoutThread](int i)
+    {
+        const QPair<QChar, SymbolData> &symbol = fontSymbols.at(i);
+        FontCache::Glyph glyph;
+
+        if (glyphPack.isOpen())
+        {
+            QPainterPath strokes;
+            bool hasStrokes = glyphPack.variantPath(i, strokes);
+            glyph = prepareSymbol(symbol.first, symbol.second, glyphPack.variant(i).svg,
+                                  hasStrokes ? &strokes : nullptr);
+        }
+        else
+        {
+            QFile file(symbol.second.fileName);
+
+            if (file.open(QIODevice::ReadOnly | QIODevice::Text))
+                glyph = prepareSymbol(symbol.first, symbol.second, file.readAll());
+        }
+
+        if (!glyph.data.isNull() && !glyph.data->renderer.isNull())
+            glyph.data->renderer->moveToThread(layoutThread);
+
+        return glyph;
+    };
+
+    return QtConcurrent::mapped(indices, prepare);
+}
+
+void SheetLayout::prepareGlyphs(const QStringRef &text)
+{
+    if (!lazyGlyphs)
+        return;
+
+    QVector<int> indices;
+
+    //every symbol is tried once, even if its files turn out to be broken
+    for (int i = 0; i < text.size(); i++)
+    {
+        ushort code = text.at(i).unicode();
+
+        if (!fontCoverage.testBit(code) || preparedSymbols.testBit(code))
+            continue;
+
+        preparedSymbols.setBit(code);
+
+        for (int index : symbolVariants.values(text.at(i)))
+            indices.push_back(index);
+    }
+
+    if (indices.isEmpty())
+        return;
+
+    std::sort(indices.begin(), indices.end()); //variants of a symbol keep the order of the eager loading
+    QElapsedTimer timer;
+    timer.start();
+    QFuture<FontCache::Glyph> glyphs = prepareSymbols(indices);
+
+    for (int i = 0; i < indices.size(); i++)
+    {
+        FontCache::Glyph glyph = glyphs.resultAt(i);
+
+        if (!glyph.data.isNull())
+            addGlyph(glyph.key, glyph.data, indices.at(i));
+    }
+
+    //symbols without a single readable variant are unknown, like the ones that aren't in the font
+    for (int i = 0; i < text.size(); i++)
+        if (fontCoverage.testBit(text.at(i).unicode()) && !font.contains(text.at(i)))
+            fontCoverage.clearBit(text.at(i).unicode());
+
+    qCDebug(renderLog) << "glyphs prepared on demand:" << indices.size() << "in" << timer.elapsed() << "ms";
+}
+
+QByteArray SheetLayout::fontParameters(const QString &fontpath) const
+{
+    //the font file is rewritten whenever the font is edited
+    QByteArray parameters;
+    QDataStream stream(&parameters, QIODevice::WriteOnly);
+    QFileInfo info(fontpath);
+    stream << info.absoluteFilePath() << info.lastModified() << info.size()
+           << dpi << fontSize << lazyGlyphs;
+
+    return parameters;
+}
+
+int SheetLayout::sheetCapacity() const
+{
+    //a generous bound: letters are seldom narrower than a quarter of the font size
+    qreal cellWidth = qMax(fontSize * dpmm / 4, 1.0);
+    qreal lineHeight = qMax(fontSize * dpmm / 2, 1.0);
+
+    return qCeil(marginsRect.width() / cellWidth) * qCeil(marginsRect.height() / lineHeight);
+}
+
+void SheetLayout::prepareGlyph(QChar symbol)
+{
+    if (!lazyGlyphs || preparedSymbols.testBit(symbol.unicode()))
+        return;
+
+    QString symbolText(symbol);
+    prepareGlyphs(QStringRef(&symbolText));
+}
+
+FontCache::Glyph SheetLayout::prepareSymbol(QChar key, const SymbolData &symbolData, const QByteArray &content,
+                                            const QPainterPath *packStrokes) const
+{
+    FontCache::Glyph glyph;
+    glyph.key = key;
+
+    //the pen isn't applied here, see restyle()
+    SvgRestyler restyler;
+    restyler.setViewBoxScaled(true); //to avoid the cut lines with an increase in the width of the line
+
+    if (!restyler.restyle(content))
+        return glyph;
+
+    QSvgRenderer *renderer = new QSvgRenderer(restyler.result());
+
+    if (!renderer->isValid())
+    {
+        delete renderer;
+        return glyph;
+    }
+
+    qreal symbolHeight = renderer->defaultSize().height() * symbolData.limits.height();
+
+    //without width and height the renderer takes its size from the viewBox, which is scaled now
+    if (!restyler.hasIntrinsicSize() && restyler.viewBox().height() > 0.0)
+        symbolHeight *= restyler.sourceViewBox().height() / restyler.viewBox().height();
+
+    qreal scale = fontSize * dpmm / symbolHeight;
+
+    QSharedPointer<SvgData> data(new SvgData);
+    data->symbolData = symbolData;
+    data->scale = scale;
+    data->size = renderer->defaultSize() * scale;
+    data->inPoint = QPointF(symbolData.inPoint.x() * data->size.width(),
+                            symbolData.inPoint.y() * data->size.height());
+    data->outPoint = QPointF(symbolData.outPoint.x() * data->size.width(),
+                             symbolData.outPoint.y() * data->size.height());
+
+    //directions of strokes are taken once here, so connections don't need to analyze paths
+    QRectF viewBoxRect = renderer->viewBoxF();
+    QTransform toSheet = QTransform::fromTranslate(-viewBoxRect.x(), -viewBoxRect.y()) *
+                         QTransform::fromScale(data->size.width() / viewBoxRect.width(),
+                                               data->size.height() / viewBoxRect.height());
+    //a glyph pack stores strokes of supported images, so they aren't parsed again
+    bool isGeometrySupported = packStrokes != nullptr;
+    QPainterPath strokes = isGeometrySupported ? *packStrokes
+                                               : restyler.path(&isGeometrySupported);
+    SvgPathParser::endTangents(strokes, toSheet, data->inTangent, data->outTangent);
+
+    //an image of strokes of one colour is drawn with the pen of the sheet, others by the renderer
+    if (isGeometrySupported && restyler.strokeColor(data->strokeColor) &&
+            restyler.lineStyle(data->strokeCap, data->strokeJoin))
+    {
+        data->strokes = toSheet.map(strokes);
+
+        for (int level = 0; level < SheetItem::lodLevels(); level++)
+            data->lodPaths.push_back(SvgPathParser::simplified(data->strokes, SheetItem::lodTolerance(level)));
+
+        delete renderer; //the strokes replace it with its document tree
+    }
+    else
+    {
+        glyph.svg = data->svg = restyler.result();
+        data->renderer.reset(renderer);
+    }
+
+    //the geometry of the glyph depends on these settings only
+    QByteArray parameters;
+    QDataStream stream(&parameters, QIODevice::WriteOnly);
+    stream << dpi << fontSize << symbolData.limits;
+
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(content);
+    hash.addData(parameters);
+    data->sourceKey = hash.result();
+
+    restyle(*data);
+    glyph.data = data;
+
+    return glyph;
+}
+
+void SheetLayout::restyle(SvgData &data) const
+{
+    //everything that changes the look of the rasterized glyph is a part of its key
+    QByteArray parameters;
+    QDataStream stream(&parameters, QIODevice::WriteOnly);
+    stream << penWidth << roundLines << useCustomFontColor << (useCustomFontColor ? fontColor : QColor());
+    data.rasterKey = QCryptographicHash::hash(data.sourceKey + parameters, QCryptographicHash::Sha1);
+
+    if (data.svg.isEmpty()) //strokes get the pen at paint time
+        return;
+
+    //the width is in units of the viewBox, so it's as wide on the sheet as the pen of strokes
+    qreal newPenWidth = penWidth * dpmm * data.renderer->viewBoxF().height() / data.size.height();
+
+    SvgRestyler restyler;
+    restyler.setPen(newPenWidth, useCustomFontColor ? fontColor : QColor(), roundLines);
+
+    if (restyler.restyle(data.svg))
+        data.renderer->load(restyler.result());
+}
+
+void SheetLayout::applyStyle()
+{
+    for (const QSharedPointer<SvgData> &data : fontGlyphs)
+        if (!data.isNull())
+            restyle(*data);
+
+    wordCache.clear(); //images of words are drawn with the previous pen
+}
+
+void SheetLayout::addGlyph(QChar key, const QSharedPointer<SvgData> &data, int id)
+{
+    data->id = id;
+
+    if (id >= fontGlyphs.size())
+        fontGlyphs.resize(id + 1);
+
+    fontGlyphs[id] = data;
+    font.insert(key, data);
+    fontCoverage.setBit(key.unicode());
+}
+
+void SheetLayout::loadSettingsFromFile()
+{
+    QSettings settings("Settings.ini", QSettings::IniFormat);
+    settings.beginGroup("Settings");
+    dpi = settings.value("dpi").toInt();
+    dpmm = dpi / 25.4;
+    letterSpacing = settings.value("letter-spacing").toDouble();
+    lineSpacing =   settings.value("line-spacing").toDouble();
+    wordSpacing =   settings.value("word-spacing").toDouble();
+    spacesInTab =   settings.value("spaces-in-tab").toInt();
+    fontSize =      settings.value("font-size").toDouble();
+    penWidth =      settings.value("pen-width").toDouble();
+    roundLines =    settings.value("round-lines").toBool();
+    useSeed =       settings.value("use-seed").toBool();
+    seed =          settings.value("seed").toInt();
+    wordWrap =      settings.value("wrap-words").toBool();
+    useCustomFontColor = settings.value("use-custom-font-color").toBool();
+    connectingLetters =     settings.value("connect-letters").toBool();
+    hyphenateWords =     settings.value("hyphenate-words").toBool();
+    wordCache.setMaxSize(settings.value("word-cache-size").toLongLong() * 1024 * 1024);
+    wordCache.setVariantsPerWord(settings.value("word-cache-variants", 4).toInt());
+
+    sheetRect = QRectF(0, 0,
+                       settings.value("sheet-width").toInt() * dpmm,
+                       settings.value("sheet-height").toInt() * dpmm);
+
+    marginsRect = QRectF(sheetRect.topLeft() + QPointF(settings.value("left-margin").toInt() * dpmm,
+                                                       settings.value("top-margin").toInt() * dpmm),
+                         sheetRect.bottomRight() - QPointF(settings.value("right-margin").toInt() * dpmm,
+                                                           settings.value("bottom-margin").toInt() * dpmm));
+
+    fontColor = QColor(settings.value("font-color").toString());
+
+    leftMarginRandomValue = settings.value("left-margin-random-value").toDouble();
+    leftMarginRandomEnabled =  settings.value("left-margin-random-enabled").toBool();
+    symbolJumpRandomValue = settings.value("symbol-jump-random-value").toDouble();
+    symbolJumpRandomEnabled =  settings.value("symbol-jump-random-enabled").toBool();
+    letterSpacingRandomValue = settings.value("letter-spacing-random-value").toDouble();
+    letterSpacingRandomEnabled =  settings.value("letter-spacing-random-enabled").toBool();
+
+    markingEnabled = settings.value("marking-enabled").toBool();
+    isMarkingLines = settings.value("is-marking-lines").toBool();
+    markingColor = QColor(settings.value("marking-color").toString());
+    markingCheckSize = settings.value("marking-check-size").toDouble();
+    markingLineSize = settings.value("marking-line-size").toDouble();
+    markingPenWidth = settings.value("marking-pen-width").toDouble();
+
+    drawLeftMargins =    settings.value("draw-left-margins").toBool();
+    drawRightMargins =   settings.value("draw-right-margins").toBool();
+    leftMarginsIndent =  settings.value("left-margins-indent").toDouble();
+    rightMarginsIndent = settings.value("right-margins-indent").toDouble();
+    marginsColor = QColor(settings.value("margins-color").toString());
+    isPaperPictureValid[0] = isPaperPictureValid[1] = false;
+
+    lazyGlyphs = settings.value("lazy-glyph-loading").toBool();
+
+    //a new pen doesn't need the files of the font again
+    QString fontpath = settings.value("last-used-font", "Font/DefaultFont.ini").toString();
+
+    if (fontParameters(fontpath) == loadedFontParameters)
+        applyStyle();
+    else
+        loadFont(fontpath);
+    settings.endGroup();
+}
+
+void SheetLayout::loadHyphenRules()
+{
+    hyphenRules.clear();
+    //load variables with their values first
+    QMap<QString, QString> variables;
+    QSettings settings("hyphenationRules.ini", QSettings::IniFormat);
+    settings.beginGroup("Variables");
+
+    for (const QString &name : settings.childKeys())
+        variables.insert(name, QString::fromUtf8(settings.value(name).toString().toLatin1()));
+
+    //than load rules
+    settings.endGroup();
+    settings.beginGroup("Rules");
+
+    for (const QString &key : settings.childKeys())
+    {
+        QString rule = settings.value(key).toString();
+
+        //and replace variables on their values
+        for (QString &variable : variables.uniqueKeys())
+            rule.replace(variable, variables[variable]);
+
+        hyphenRules.push_back(QRegularExpression(rule));
+    }
+
+    settings.endGroup();
+}
+
+void SheetLayout::adopt(SheetDisplayList &sheet)
+{
+    //no glyph of the other instance may stay, its renderer would be destroyed in a wrong thread
+    auto ownGlyph = [this](const QSharedPointer<SvgData> &data) -> QSharedPointer<SvgData>
+    {
+        int id = data->id;
+
+        //ids are indices in the font index, so a lazily loaded glyph is prepared here
+        if (lazyGlyphs && id < fontSymbols.size())
+            prepareGlyph(fontSymbols.at(id).first);
+
+        return id < fontGlyphs.size() ? fontGlyphs.at(id) : QSharedPointer<SvgData>();
+    };
+
+    QVector<PlacedGlyph> glyphs;
+    QVector<int> newIndices(sheet.glyphs.size(), -1);
+    glyphs.reserve(sheet.glyphs.size());
+
+    for (int i = 0; i < sheet.glyphs.size(); i++)
+    {
+        PlacedGlyph glyph = sheet.glyphs.at(i);
+        glyph.svgData = ownGlyph(glyph.svgData);
+
+        if (glyph.svgData.isNull())
+            continue;
+
+        newIndices[i] = glyphs.size();
+        glyphs.push_back(glyph);
+    }
+
+    if (glyphs.size() < sheet.glyphs.size())
+        qCWarning(renderLog) << sheet.glyphs.size() - glyphs.size()
+                             << "glyphs of an adopted sheet aren't in the font and are dropped";
+
+    //a variant can be placed several times, it's copied once
+    QHash<const WordVariant *, QSharedPointer<WordVariant>> variants;
+
+    for (PlacedWord &word : sheet.words)
+    {
+        QSharedPointer<WordVariant> &variant = variants[word.variant.data()];
+
+        if (variant.isNull())
+        {
+            variant.reset(new WordVariant(*word.variant));
+
+            for (PlacedGlyph &glyph : variant->glyphs)
+            {
+                glyph.svgData = ownGlyph(glyph.svgData);
+
+                if (glyph.svgData.isNull()) //the word is drawn glyph by glyph
+                {
+                    variant->glyphs.clear();
+                    variant->image = QImage();
+                    break;
+                }
+            }
+        }
+
+        word.variant = variant;
+        word.firstGlyph = newIndices.value(word.firstGlyph, -1);
+
+        if (word.firstGlyph < 0) //the beginning of the word is dropped
+        {
+            word.variant.reset(new WordVariant(*variant));
+            word.variant->glyphs.clear();
+            word.variant->image = QImage();
+            word.firstGlyph = 0;
+        }
+    }
+
+    sheet.glyphs = glyphs;
+}
+
+QRectF SheetLayout::getMarginsRect(bool changedMargins) const
+{
+    QRectF changedMarginsRect;
+
+    if (changedMargins)
+        changedMarginsRect = QRectF(QPointF(sheetRect.topRight().x() - marginsRect.topRight().x(),
+                                            marginsRect.topLeft().y()),
+                                    QPointF(sheetRect.bottomRight().x() - marginsRect.bottomLeft().x(),
+                                            marginsRect.bottomRight().y()));
+    else
+        changedMarginsRect = marginsRect;
+
+    return changedMarginsRect;
+}
+
+QRectF SheetLayout::changedVerticalMargins() const
+{
+    return getMarginsRect(changeMargins);
+}
+
+void SheetLayout::randomizeMargins()
+{
+    currentMarginsRect = changedVerticalMargins();
+
+    if (!leftMarginRandomEnabled || leftMarginRandomValue == 0)
+        return;
+
+    qreal random = qrand() % uint(leftMarginRandomValue * dpmm);
+    if (qrand() % 2)
+        random = -random;
+
+    currentMarginsRect.setLeft(currentMarginsRect.x() + (leftMarginRandomValue * dpmm) + random);
+}
+
+void SheetLayout::cursorToNewLine()
+{
+    randomizeMargins();
+    cursor.rx() = currentMarginsRect.x();
+    cursor.ry() += (fontSize + lineSpacing) * dpmm;
+}
+
+QPointF SheetLayout::symbolPositionRandomValue()
+{
+    QPointF randomPos(0.0, 0.0);
+
+    if (!symbolJumpRandomEnabled || symbolJumpRandomValue == 0)
+        return randomPos;
+
+    qreal randomY = qrand() % uint(symbolJumpRandomValue * dpmm);
+    if (qrand() % 2)
+        randomY = -randomY;
+
+    randomPos.setY(randomY);
+
+    return randomPos;
+}
+
+void SheetLayout::randomizeLetterSpacing()
+{
+    currentLetterSpacing = letterSpacing;
+    if (!letterSpacingRandomEnabled || letterSpacingRandomValue == 0)
+        return;
+
+    qreal random = qrand() % uint(letterSpacingRandomValue * dpmm);
+    if (qrand() % 2)
+        random = -random;
+
+    currentLetterSpacing += random;
+}
+
+void SheetLayout::updatePaperPicture()
+{
+    int index = changeMargins ? 1 : 0;
+
+    if (!isPaperPictureValid[index])
+    {
+        paperPictures[index] = QPicture();
+        QPainter painter(&paperPictures[index]);
+        painter.setRenderHint(QPainter::Antialiasing);
+        drawMarking(&painter);
+        drawMargins(&painter);
+        painter.end();
+        isPaperPictureValid[index] = true;
+    }
+}
+
+void SheetLayout::drawMarking(QPainter *painter)
+{
+    if (!markingEnabled)
+        return;
+
+    qreal width = markingPenWidth * dpmm;
+    qreal lineSize = markingLineSize * dpmm;
+    qreal checkSize = markingCheckSize * dpmm;
+    //y is under the first line of text
+    qreal y = marginsRect.top() + fontSize * dpmm + width;
+
+    QPen pen;
+    pen.setColor(markingColor);
+    pen.setWidth(width);
+    painter->setPen(pen);
+
+    QVector<QLineF> lines;
+
+    if (isMarkingLines)
+    {
+        for (; y <= changedVerticalMargins().bottom(); y += lineSize)
+            lines.push_back(QLineF(0.0, y, sheetRect.right(), y));
+    }
+    else
+    {
+        while (y > checkSize * 2)
+            y -= checkSize;
+
+        for (; y <= sheetRect.bottom(); y += checkSize)
+        {
+            lines.push_back(QLineF(0.0, y - checkSize, sheetRect.right(), y - checkSize));
+            lines.push_back(QLineF(0.0, y, sheetRect.right(), y));
+        }
+
+         for (qreal x = sheetRect.left(); x < sheetRect.right(); x += checkSize)
+             lines.push_back(QLineF(x, 0.0, x, sheetRect.bottom()));
+    }
+
+    painter->drawLines(lines);
+}
+
+void SheetLayout::drawMargins(QPainter *painter)
+{
+    if (!(drawLeftMargins || drawRightMargins))
+        return;
+
+    QPen pen;
+    pen.setColor(marginsColor);
+    pen.setWidth(markingPenWidth * dpmm * 2);
+    painter->setPen(pen);
+    qreal leftX, rightX;
+
+    if (changeMargins)
+    {
+        rightX = rightMarginsIndent * dpmm;
+        leftX = sheetRect.right() - leftMarginsIndent * dpmm;
+    }
+    else
+    {
+        rightX = sheetRect.right() - rightMarginsIndent * dpmm;
+        leftX = leftMarginsIndent * dpmm;
+    }
+
+    if (drawLeftMargins)
+        painter->drawLine(QLineF(leftX, 0.0, leftX, sheetRect.bottom()));
+
+    if (drawRightMargins)
+        painter->drawLine(QLineF(rightX, 0.0, rightX, sheetRect.bottom()));
+}
@@ -0,0 +1,175 @@
+/*!
+    SheetLayout - places characters of a text on a sheet.
+
+    It loads a font and the settings that affect placement, and lays
+    a text out into a SheetDisplayList. It isn't a widget, so SvgView
+    and RenderWorker have their own instances: every instance owns its
+    font, and instances can work in different threads.
+
+    An algorithm that places characters on a sheet is described in the function
+    layOutText(). It takes the QStringRef with text, places as many characters
+    as possible on a single sheet and returns the number of the first character
+    that function has not processed.
+
+    preventGoingBeyondRightMargin() prevents going beyond right margin
+    by wrapping or hypphenating words, or just simply starts a new line.
+
+    The paper (marking and margins) is recorded once per settings into
+    a QPicture, which is shared by all laid out sheets.
+
+    Glyphs of a font are compiled once per font files and settings and
+    are stored in a FontCache, so loadFont() usually reads just one file.
+    Compiling is done by the global thread pool, one glyph per task; only
+    adding the glyphs to the font is serial.
+
+    The pen (width, colour, round lines) isn't a part of compiled glyphs:
+    strokes are drawn with it at paint time and other images are restyled
+    from memory, so a new pen in settings doesn't reload the font.
+
+    With "lazy-glyph-loading", loadFont() reads only the index of the font
+    and a glyph is prepared when its symbol is placed first; layOutText()
+    pre-scans the text of a sheet to prepare its symbols at once. An
+    instance is used by one thread, so a bit per symbol is enough to do
+    it once; SvgData::id is the index of the variant in the font, so
+    instances agree on ids whatever glyphs they have prepared.
+
+    If "word-cache-size" isn't 0, words of two letters and more are taken
+    from a WordCache with "word-cache-variants" variants of every word.
+*/
+#ifndef SHEETLAYOUT_H
+#define SHEETLAYOUT_H
+
+#include <QtCore/QRegularExpression>
+#include <QtCore/QTextCodec>
+#include <QtCore/QSettings>
+#include <QtCore/QtMath>
+#include <QtCore/QBitArray>
+#include <QtCore/QHash>
+#include <QtCore/QCryptographicHash>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QDateTime>
+#include <QtCore/QFileInfo>
+#include <QtCore/QThread>
+#include <QtConcurrent/QtConcurrentMap>
+#include <functional>
+#include <numeric>
+#include <random>
+#include <QtGui/QPicture>
+#include <QtSvg/QSvgRenderer>
+
+#include "symboldata.h"
+#include "svgdata.h"
+#include "sheetdisplaylist.h"
+#include "wordcache.h"
+#include "fontcache.h"
+#include "glyphpack.h"
+#include "svgpathparser.h"
+#include "svgrestyler.h"
+#include "missingglyphs.h"
+#include "renderstatistics.h"
+
+class SheetLayout
+{
+public:
+    SheetLayout();
+
+    int layOutText(const QStringRef &text, bool changedMargins, SheetDisplayList &sheet);
+    bool loadFont(QString fontpath = QString()); //!< returns false if there is no font in the file
+    void loadSettingsFromFile(); //!< loads the last used font too
+    void releaseGlyphPack(const QString &fileName); //!< unmaps the pack of the font until loadFont(), so it can be replaced
+    void adopt(SheetDisplayList &sheet); //!< replaces glyphs of a sheet laid out by another instance with own ones
+    void prepareGlyphs(const QStringRef &text); //!< in lazy mode, prepares glyphs of all symbols of the text at once
+
+    QList<QChar> getFontKeys() const {return lazyGlyphs ? symbolVariants.uniqueKeys() : font.uniqueKeys();}
+    const QBitArray & getFontCoverage() const {return fontCoverage;}
+    const RenderStatistics & getRenderStatistics() const {return statistics;}
+    int getDpi() const {return dpi;}
+    QRectF getSheetRect() const {return sheetRect;}
+    QRectF getMarginsRect(bool changedMargins) const;
+    //! the pen of glyph strokes; the colour is invalid if glyphs keep their own one, without
+    //! round lines glyphs keep their caps and joins, see SvgData::draw()
+    QPen strokePen() const;
+    QPen connectionPen() const;
+    //! restyles the font with a pen that isn't saved in settings yet; returns false if the pen is the same
+    bool setPen(qreal width, const QColor &color, bool useCustomColor, bool round);
+    //! called by loadFont() in its thread after every compiled glyph
+    void setFontProgressHandler(const std::function<void(int loaded, int total)> &handler) {fontProgress = handler;}
+
+private:
+    QMultiMap<QChar, QSharedPointer<SvgData>> font;
+    QVector<QSharedPointer<SvgData>> fontGlyphs; //!< glyphs by SvgData::id; null for not yet prepared ones in lazy mode
+    QVector<QPair<QChar, SymbolData>> fontSymbols; //!< all variants of the font, files aren't read yet
+    QMultiHash<QChar, int> symbolVariants; //!< indices in fontSymbols, used in lazy mode
+    QBitArray preparedSymbols; //!< symbols whose glyphs were prepared in lazy mode
+    bool lazyGlyphs;
+    QByteArray loadedFontParameters; //!< see fontParameters()
+    WordCache wordCache;
+    FontCache fontCache;
+    GlyphPack glyphPack; //!< mapped while its font is loaded
+    std::function<void(int loaded, int total)> fontProgress;
+    QBitArray fontCoverage; //!< bit for every UTF-16 code unit that has at least one glyph in the font
+    MissingGlyphs missingGlyphs;
+    RenderStatistics statistics;
+    SheetDisplayList *sheet; //!< the sheet that is laid out now
+    QPicture paperPictures[2]; //!< marking and margins lines for usual and changed left/right margins
+    bool isPaperPictureValid[2];
+    QVector<QVector<int>> storedWordItems; //!< there stored indices of sheet glyphs that forming words
+    QVector<QVector<SymbolData>> storedSymbolData; //!< data for items in storedWordItems
+    int dpi;  //!< dots per inch
+    int dpmm; //!< dots per millimeter
+    int spacesInTab;
+    int seed;
+    uint itemsToRemove;
+    bool useCustomFontColor, changeMargins, connectingLetters,
+         useSeed, roundLines, wordWrap, hyphenateWords,
+         leftMarginRandomEnabled, symbolJumpRandomEnabled, letterSpacingRandomEnabled,
+         markingEnabled, isMarkingLines, drawLeftMargins, drawRightMargins;
+    qreal fontSize, penWidth, letterSpacing, lineSpacing, wordSpacing,
+          leftMarginRandomValue, symbolJumpRandomValue, letterSpacingRandomValue,
+          markingCheckSize, markingLineSize, markingPenWidth, leftMarginsIndent, rightMarginsIndent;
+    QRectF sheetRect, marginsRect;
+    QColor fontColor, markingColor, marginsColor;
+    QVector<QRegularExpression> hyphenRules;
+
+    SymbolData symbolData, previousSymbolData;
+    QRectF currentMarginsRect;
+    qreal currentLetterSpacing;
+    QSizeF symbolBoundingSize;
+    QPointF cursor; /*!< cursor is pointing to where will be placed
+                         the top left corner of the next character limits */
+    QPointF previousSymbolCursor;
+    qreal previousSymbolWidth;
+
+    void prepareToLayOut();
+    void updatePaperPicture();
+    bool preventGoingBeyondRightMargin(qreal letterWidth, QStringRef text, int currentSymbolIndex);
+    void connectLetters();
+    int placeCachedWord(const QStringRef &text, int wordBegin); //!< returns the number of placed letters
+    QSharedPointer<WordVariant> buildWordVariant(const QString &word, int variant);
+    void processUnknownSymbol(const QChar &symbol);
+    //! thread-safe; strokes of the image from a glyph pack, if any, replace parsing of its paths
+    FontCache::Glyph prepareSymbol(QChar key, const SymbolData &symbolData, const QByteArray &content,
+                                   const QPainterPath *packStrokes = nullptr) const;
+    QFuture<FontCache::Glyph> prepareSymbols(const QVector<int> &indices) const; //!< fontSymbols on the thread pool
+    void prepareGlyph(QChar symbol); //!< in lazy mode, prepares variants of the symbol once
+    void restyle(SvgData &data) const; //!< applies the pen of settings to a glyph the renderer draws
+    void applyStyle(); //!< restyle() of all glyphs of the font
+    QByteArray fontParameters(const QString &fontpath) const; //!< the font file and settings that need to load it again
+    int sheetCapacity() const; //!< at most so many characters fit on a sheet
+    void addGlyph(QChar key, const QSharedPointer<SvgData> &data, int id);
+    bool wrapWords(QStringRef text, int currentSymbolIndex);
+    bool wrapLastSymbols(int symbolsToWrap);
+    void removeLastSymbols();
+    bool hyphenate(QStringRef text, int currentSymbolIndex);
+    void loadHyphenRules();
+    QRectF changedVerticalMargins() const;
+    PlacedGlyph generateHyphen(int symbolsToWrap);
+    void randomizeMargins();
+    void randomizeLetterSpacing();
+    QPointF symbolPositionRandomValue();
+    void cursorToNewLine();
+    void drawMarking(QPainter *painter);
+    void drawMargins(QPainter *painter);
+};
+
+#endif // SHEETLAYOUT_H
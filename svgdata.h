@@ -0,0 +1,82 @@
+/*!
+    SvgData - one variant of a symbol of the loaded font, prepared
+    to be placed on a sheet.
+
+    It's created by SheetLayout::prepareSymbol() and shared between the font
+    and sheets, that are placed with it, so a sheet stays valid
+    even if the font is reloaded.
+
+    The geometry doesn't depend on the pen: if the image is made of
+    strokes only, its paths are parsed once into strokes in coordinates
+    of the sheet and draw() strokes them with the pen of the sheet, so
+    pen width, colour and caps are applied at paint time and the glyph
+    keeps no QSvgRenderer. Images with other shapes, fills or several
+    colours are drawn by the renderer, which SheetLayout::restyle()
+    reloads from svg in memory when the pen changes.
+*/
+#ifndef SVGDATA_H
+#define SVGDATA_H
+
+#include <QtCore/QByteArray>
+#include <QtCore/QSharedPointer>
+#include <QtCore/QScopedPointer>
+#include <QtCore/QVector>
+#include <QtGui/QColor>
+#include <QtGui/QPainter>
+#include <QtGui/QPainterPath>
+#include <QtGui/QPen>
+#include <QtSvg/QSvgRenderer>
+
+#include "symboldata.h"
+
+struct SvgData
+{
+    SymbolData symbolData;
+    int id;       //!< number of the glyph in the font; copies of a font loaded with the same settings match
+    qreal scale;  //!< scale of the image to get a symbol of the font size
+    QSizeF size;  //!< size of the scaled image on the sheet
+    QPointF inPoint, outPoint; //!< connection points relative to the top left corner of the scaled image
+    QPointF inTangent, outTangent; //!< unit directions of the stroke at its begin and end; null if unknown
+    QByteArray sourceKey; //!< hash of the SVG file and the settings of the geometry
+    QByteArray rasterKey; //!< sourceKey with the pen it's drawn with; empty if unknown
+    QPainterPath strokes; //!< strokes relative to the top left corner with the viewBox applied; drawn if there is no renderer
+    QColor strokeColor;   //!< colour of the strokes in the image
+    Qt::PenCapStyle strokeCap = Qt::FlatCap;       //!< caps of the strokes in the image
+    Qt::PenJoinStyle strokeJoin = Qt::SvgMiterJoin; //!< joins of the strokes in the image
+    QVector<QPainterPath> lodPaths; //!< simplified strokes relative to the top left corner, see SheetItem::lodTolerance()
+    QByteArray svg; //!< the image before restyling; only for glyphs drawn by the renderer
+    QScopedPointer<QSvgRenderer> renderer; //!< null for strokes, only other images carry a document tree
+
+    //! draws the glyph scaled to rect; a pen with an invalid colour keeps the colour of the image,
+    //! a pen without round caps keeps caps and joins of the image
+    void draw(QPainter *painter, const QRectF &rect, const QPen &pen) const
+    {
+        if (!renderer.isNull())
+        {
+            renderer->render(painter, rect);
+            return;
+        }
+
+        QPen strokePen(pen);
+
+        if (!pen.color().isValid())
+            strokePen.setColor(strokeColor);
+
+        if (pen.capStyle() != Qt::RoundCap)
+        {
+            strokePen.setCapStyle(strokeCap);
+            strokePen.setJoinStyle(strokeJoin);
+            strokePen.setMiterLimit(4.0); //the default of SVG
+        }
+
+        painter->save();
+        painter->translate(rect.topLeft());
+        painter->scale(rect.width() / size.width(), rect.height() / size.height());
+        painter->setPen(strokePen);
+        painter->setBrush(Qt::NoBrush);
+        painter->drawPath(strokes);
+        painter->restore();
+    }
+};
+
+#endif // SVGDATA_H
@@ -0,0 +1,382 @@
+#include "svgpathparser.h"
+
+#include <QtCore/QRegularExpression>
+#include <QtCore/QtMath>
+
+QPainterPath SvgPathParser::parse(const QString &pathData, bool *supported)
+{
+    QPainterPath path;
+    QPointF current, subpathStart, lastControl;
+    QChar command, lastCurve; //lastCurve is 'c' or 'q' if the previous command was a curve
+    bool isSupported = true;
+    int position = 0;
+
+    while (true)
+    {
+        skipSeparators(pathData, position);
+
+        if (position >= pathData.size())
+            break;
+
+        if (pathData.at(position).isLetter())
+            command = pathData.at(position++);
+        else if (command.isNull()) //numbers without a command
+        {
+            isSupported = false;
+            break;
+        }
+
+        bool relative = command.isLower();
+        QPointF origin = relative ? current : QPointF(0.0, 0.0);
+        QChar curve;
+        qreal n[7];
+        bool ok = true;
+
+        switch (command.toLower().unicode())
+        {
+        case 'm':
+            ok = readNumber(pathData, position, n[0]) && readNumber(pathData, position, n[1]);
+            if (!ok)
+                break;
+            current = origin + QPointF(n[0], n[1]);
+            subpathStart = current;
+            path.moveTo(current);
+            command = relative ? 'l' : 'L'; //the following pairs are implicit lines
+            break;
+
+        case 'l':
+            ok = readNumber(pathData, position, n[0]) && readNumber(pathData, position, n[1]);
+            if (!ok)
+                break;
+            current = origin + QPointF(n[0], n[1]);
+            path.lineTo(current);
+            break;
+
+        case 'h':
+            ok = readNumber(pathData, position, n[0]);
+            if (!ok)
+                break;
+            current.rx() = origin.x() + n[0];
+            path.lineTo(current);
+            break;
+
+        case 'v':
+            ok = readNumber(pathData, position, n[0]);
+            if (!ok)
+                break;
+            current.ry() = origin.y() + n[0];
+            path.lineTo(current);
+            break;
+
+        case 'c':
+        {
+            for (int i = 0; i < 6 && ok; i++)
+                ok = readNumber(pathData, position, n[i]);
+            if (!ok)
+                break;
+            QPointF c1 = origin + QPointF(n[0], n[1]);
+            lastControl = origin + QPointF(n[2], n[3]);
+            current = origin + QPointF(n[4], n[5]);
+            path.cubicTo(c1, lastControl, current);
+            curve = 'c';
+            break;
+        }
+
+        case 's':
+        {
+            for (int i = 0; i < 4 && ok; i++)
+                ok = readNumber(pathData, position, n[i]);
+            if (!ok)
+                break;
+            QPointF c1 = lastCurve == 'c' ? current * 2.0 - lastControl : current;
+            lastControl = origin + QPointF(n[0], n[1]);
+            current = origin + QPointF(n[2], n[3]);
+            path.cubicTo(c1, lastControl, current);
+            curve = 'c';
+            break;
+        }
+
+        case 'q':
+            for (int i = 0; i < 4 && ok; i++)
+                ok = readNumber(pathData, position, n[i]);
+            if (!ok)
+                break;
+            lastControl = origin + QPointF(n[0], n[1]);
+            current = origin + QPointF(n[2], n[3]);
+            path.quadTo(lastControl, current);
+            curve = 'q';
+            break;
+
+        case 't':
+            ok = readNumber(pathData, position, n[0]) && readNumber(pathData, position, n[1]);
+            if (!ok)
+                break;
+            lastControl = lastCurve == 'q' ? current * 2.0 - lastControl : current;
+            current = origin + QPointF(n[0], n[1]);
+            path.quadTo(lastControl, current);
+            curve = 'q';
+            break;
+
+        case 'a': //arcs are rare in freehand strokes, so they are replaced with lines
+            for (int i = 0; i < 7 && ok; i++)
+                ok = readNumber(pathData, position, n[i]);
+            if (!ok)
+                break;
+            current = origin + QPointF(n[5], n[6]);
+            path.lineTo(current);
+            isSupported = false;
+            break;
+
+        case 'z':
+            path.closeSubpath();
+            current = subpathStart;
+            command = QChar();
+            break;
+
+        default:
+            ok = false;
+            break;
+        }
+
+        if (!ok)
+        {
+            isSupported = false;
+            break;
+        }
+
+        lastCurve = curve;
+    }
+
+    if (supported != nullptr)
+        *supported = isSupported;
+
+    return path;
+}
+
+QTransform SvgPathParser::parseTransform(const QString &transform)
+{
+    QTransform result;
+    QRegularExpressionMatchIterator i = QRegularExpression("(\\w+)\\s*\\(([^)]*)\\)").globalMatch(transform);
+
+    while (i.hasNext())
+    {
+        QRegularExpressionMatch match = i.next();
+        QString name = match.captured(1);
+        QStringList values = match.captured(2).split(QRegularExpression("[\\s,]+"), QString::SkipEmptyParts);
+        QVector<qreal> n;
+
+        for (const QString &value : values)
+            n.push_back(value.toDouble());
+
+        QTransform current;
+
+        if (name == "translate" && n.size() >= 1)
+            current = QTransform::fromTranslate(n.at(0), n.size() > 1 ? n.at(1) : 0.0);
+
+        if (name == "scale" && n.size() >= 1)
+            current = QTransform::fromScale(n.at(0), n.size() > 1 ? n.at(1) : n.at(0));
+
+        if (name == "matrix" && n.size() >= 6)
+            current = QTransform(n.at(0), n.at(1), n.at(2), n.at(3), n.at(4), n.at(5));
+
+        if (name == "rotate" && n.size() >= 1)
+        {
+            QPointF center = n.size() >= 3 ? QPointF(n.at(1), n.at(2)) : QPointF(0.0, 0.0);
+            current = QTransform::fromTranslate(-center.x(), -center.y()) *
+                      QTransform().rotate(n.at(0)) *
+                      QTransform::fromTranslate(center.x(), center.y());
+        }
+
+        if (name == "skewX" && n.size() >= 1)
+            current = QTransform(1.0, 0.0, qTan(qDegreesToRadians(n.at(0))), 1.0, 0.0, 0.0);
+
+        if (name == "skewY" && n.size() >= 1)
+            current = QTransform(1.0, qTan(qDegreesToRadians(n.at(0))), 0.0, 1.0, 0.0, 0.0);
+
+        //transforms in a list are applied from right to left
+        result = current * result;
+    }
+
+    return result;
+}
+
+void SvgPathParser::endTangents(const QPainterPath &path, const QTransform &transform,
+                                QPointF &beginTangent, QPointF &endTangent)
+{
+    QPointF previous, begin, end;
+    bool hasBegin = false;
+
+    for (int i = 0; i < path.elementCount(); i++)
+    {
+        const QPainterPath::Element &element = path.elementAt(i);
+        QPointF point(element.x, element.y);
+        QPointF startDirection, endDirection;
+
+        if (element.isMoveTo())
+        {
+            previous = point;
+            continue;
+        }
+
+        if (element.isLineTo())
+        {
+            startDirection = endDirection = point - previous;
+            previous = point;
+        }
+
+        if (element.isCurveTo() && i + 2 < path.elementCount())
+        {
+            QPointF c2(path.elementAt(i + 1).x, path.elementAt(i + 1).y);
+            QPointF p3(path.elementAt(i + 2).x, path.elementAt(i + 2).y);
+
+            //control points can coincide with the ends of a curve
+            startDirection = point - previous;
+            if (startDirection.isNull())
+                startDirection = c2 - previous;
+            if (startDirection.isNull())
+                startDirection = p3 - previous;
+
+            endDirection = p3 - c2;
+            if (endDirection.isNull())
+                endDirection = p3 - point;
+            if (endDirection.isNull())
+                endDirection = p3 - previous;
+
+            previous = p3;
+            i += 2;
+        }
+
+        if (startDirection.isNull())
+            continue;
+
+        if (!hasBegin)
+        {
+            begin = startDirection;
+            hasBegin = true;
+        }
+
+        end = endDirection;
+    }
+
+    //only the linear part of the transform is applied to directions
+    beginTangent = unitVector(transform.map(begin) - transform.map(QPointF(0.0, 0.0)));
+    endTangent = unitVector(transform.map(end) - transform.map(QPointF(0.0, 0.0)));
+}
+
+QPainterPath SvgPathParser::simplified(const QPainterPath &path, qreal tolerance)
+{
+    QPainterPath result;
+
+    for (const QPolygonF &polyline : path.toSubpathPolygons())
+    {
+        if (polyline.size() < 2)
+            continue;
+
+        QVector<bool> keep(polyline.size(), false);
+        keep.first() = keep.last() = true;
+        simplifyPolyline(polyline, 0, polyline.size() - 1, tolerance, keep);
+
+        result.moveTo(polyline.first());
+
+        for (int i = 1; i < polyline.size(); i++)
+            if (keep.at(i))
+                result.lineTo(polyline.at(i));
+    }
+
+    return result;
+}
+
+void SvgPathParser::simplifyPolyline(const QPolygonF &polyline, int first, int last,
+                                     qreal tolerance, QVector<bool> &keep)
+{
+    //Ramer-Douglas-Peucker: keep the farthest point from the chord and split there
+    QPointF chord = polyline.at(last) - polyline.at(first);
+    qreal chordLength = qSqrt(QPointF::dotProduct(chord, chord));
+    qreal maxDistance = 0.0;
+    int farthest = -1;
+
+    for (int i = first + 1; i < last; i++)
+    {
+        QPointF vector = polyline.at(i) - polyline.at(first);
+        qreal distance = qFuzzyIsNull(chordLength)
+                ? qSqrt(QPointF::dotProduct(vector, vector))
+                : qAbs(vector.x() * chord.y() - vector.y() * chord.x()) / chordLength;
+
+        if (distance > maxDistance)
+        {
+            maxDistance = distance;
+            farthest = i;
+        }
+    }
+
+    if (farthest < 0 || maxDistance <= tolerance)
+        return;
+
+    keep[farthest] = true;
+    simplifyPolyline(polyline, first, farthest, tolerance, keep);
+    simplifyPolyline(polyline, farthest, last, tolerance, keep);
+}
+
+void SvgPathParser::skipSeparators(const QString &data, int &position)
+{
+    while (position < data.size() && (data.at(position).isSpace() || data.at(position) == ','))
+        position++;
+}
+
+bool SvgPathParser::readNumber(const QString &data, int &position, qreal &number)
+{
+    skipSeparators(data, position);
+
+    int start = position;
+    bool hasDigits = false, hasDot = false;
+
+    if (position < data.size() && (data.at(position) == '-' || data.at(position) == '+'))
+        position++;
+
+    for (; position < data.size(); position++)
+    {
+        QChar symbol = data.at(position);
+
+        if (symbol.isDigit())
+            hasDigits = true;
+        else if (symbol == '.' && !hasDot) //"1.5.5" means two numbers: 1.5 and .5
+            hasDot = true;
+        else
+            break;
+    }
+
+    if (!hasDigits)
+    {
+        position = start;
+        return false;
+    }
+
+    if (position < data.size() && (data.at(position) == 'e' || data.at(position) == 'E'))
+    {
+        int exponent = position + 1;
+
+        if (exponent < data.size() && (data.at(exponent) == '-' || data.at(exponent) == '+'))
+            exponent++;
+
+        if (exponent < data.size() && data.at(exponent).isDigit())
+        {
+            position = exponent;
+
+            while (position < data.size() && data.at(position).isDigit())
+                position++;
+        }
+    }
+
+    number = data.midRef(start, position - start).toDouble();
+    return true;
+}
+
+QPointF SvgPathParser::unitVector(const QPointF &vector)
+{
+    qreal length = qSqrt(vector.x() * vector.x() + vector.y() * vector.y());
+
+    if (qFuzzyIsNull(length))
+        return QPointF(0.0, 0.0);
+
+    return vector / length;
+}
@@ -0,0 +1,45 @@
+/*!
+    SvgPathParser - converts path data of SVG images into QPainterPath.
+
+    Fonts of Scribbler consist of freehand strokes, so glyphs contain
+    only "path" elements. The parser understands all commands of the
+    path data except arcs, which are replaced with straight lines, and
+    applies "transform" attributes of the path and its parents.
+
+    SvgRestyler collects path data and transforms of an image and
+    reports whether it contains anything else than paths, so the caller
+    can decide whether the geometry is enough to draw the glyph.
+
+    simplified() flattens strokes for the zoomed out preview of a sheet.
+*/
+#ifndef SVGPATHPARSER_H
+#define SVGPATHPARSER_H
+
+#include <QtCore/QString>
+#include <QtCore/QVector>
+#include <QtGui/QPainterPath>
+#include <QtGui/QPolygonF>
+#include <QtGui/QTransform>
+
+class SvgPathParser
+{
+public:
+    static QPainterPath parse(const QString &pathData, bool *supported = nullptr);
+    static QTransform parseTransform(const QString &transform);
+
+    //! directions of the first and the last stroke of the path mapped with transform, as unit vectors
+    static void endTangents(const QPainterPath &path, const QTransform &transform,
+                            QPointF &beginTangent, QPointF &endTangent);
+
+    //! the path flattened to polylines without points that deviate less than tolerance from them
+    static QPainterPath simplified(const QPainterPath &path, qreal tolerance);
+
+private:
+    static void skipSeparators(const QString &data, int &position);
+    static bool readNumber(const QString &data, int &position, qreal &number);
+    static QPointF unitVector(const QPointF &vector);
+    static void simplifyPolyline(const QPolygonF &polyline, int first, int last,
+                                 qreal tolerance, QVector<bool> &keep);
+};
+
+#endif // SVGPATHPARSER_H
@@ -0,0 +1,313 @@
+#include "svgrestyler.h"
+#include "svgpathparser.h"
+
+#include <QtCore/QRegularExpression>
+
+SvgRestyler::SvgRestyler()
+{
+    isViewBoxScaled = false;
+    hasPen = false;
+    isRoundLines = false;
+    penWidth = 0.0;
+    isSizeSet = false;
+    hasOtherShapes = false;
+}
+
+void SvgRestyler::setPen(qreal width, const QColor &color, bool roundLines)
+{
+    hasPen = true;
+    penWidth = width;
+    penColor = color;
+    isRoundLines = roundLines;
+}
+
+bool SvgRestyler::restyle(const QByteArray &svg)
+{
+    output.clear();
+    output.reserve(svg.size() + 256);
+    viewBoxRect = sourceViewBoxRect = QRectF();
+    isSizeSet = false;
+    paths.clear();
+    pathTransforms.clear();
+    groupTransform.clear();
+    hasOtherShapes = false;
+    declarations.clear();
+
+    QXmlStreamReader reader(svg);
+    reader.setNamespaceProcessing(false); //prefixes and xmlns attributes are copied as they are
+    QXmlStreamWriter writer(&output);
+
+    const QStringList otherShapes = {"line", "polyline", "polygon", "rect", "circle",
+                                     "ellipse", "text", "use", "image"};
+    QVector<QTransform> transforms; //of open elements; own transform is applied first, then the ones of the parents
+    bool isRootFound = false, isGroupFound = false, isStyleFound = false;
+
+    while (!reader.atEnd())
+    {
+        if (reader.readNext() != QXmlStreamReader::StartElement)
+        {
+            if (reader.isEndElement())
+                transforms.pop_back();
+
+            if (!reader.hasError())
+                writer.writeCurrentToken(reader);
+
+            continue;
+        }
+
+        QStringRef name = reader.name();
+        QXmlStreamAttributes attributes = reader.attributes();
+        transforms.push_back(SvgPathParser::parseTransform(attributes.value("transform").toString()) *
+                             (transforms.isEmpty() ? QTransform() : transforms.last()));
+        collectDeclarations(attributes);
+
+        if (name == "svg" && !isRootFound)
+        {
+            isRootFound = true;
+            isSizeSet = attributes.hasAttribute("width") && attributes.hasAttribute("height");
+            QString viewBox = attributes.value("viewBox").toString();
+            sourceViewBoxRect = toRect(viewBox);
+
+            if (isViewBoxScaled && !sourceViewBoxRect.isNull())
+            {
+                viewBox = scaledViewBox(viewBox);
+                setAttribute(attributes, "viewBox", viewBox);
+            }
+
+            viewBoxRect = toRect(viewBox);
+        }
+        else if (name == "g" && !isGroupFound)
+        {
+            isGroupFound = true;
+            groupTransform = attributes.value("transform").toString();
+        }
+        else if (name == "path")
+        {
+            paths << attributes.value("d").toString();
+            pathTransforms << transforms.last();
+
+            //the style of paths is changed only if there is no style sheet
+            if (hasPen && !isStyleFound)
+            {
+                QString style = attributes.value("style").toString();
+                changeStyle(style);
+                setAttribute(attributes, "style", style);
+            }
+        }
+        else if (otherShapes.contains(name.toString()))
+            hasOtherShapes = true;
+
+        writer.writeStartElement(reader.qualifiedName().toString());
+        writer.writeAttributes(attributes);
+
+        if (name != "style")
+            continue;
+
+        //the style sheet is read at once, so the pen goes into the first one only
+        QString style = reader.readElementText(QXmlStreamReader::IncludeChildElements);
+        transforms.pop_back();
+        declarations << style;
+
+        if (hasPen && !isStyleFound)
+        {
+            changeStyle(style);
+            writer.writeCDATA(style);
+        }
+        else
+            writer.writeCharacters(style);
+
+        writer.writeEndElement();
+        isStyleFound = true;
+    }
+
+    if (reader.hasError())
+    {
+        output.clear();
+        return false;
+    }
+
+    return true;
+}
+
+QPainterPath SvgRestyler::path(bool *supported) const
+{
+    QPainterPath result;
+    bool isSupported = !hasOtherShapes;
+
+    for (int i = 0; i < paths.size(); i++)
+    {
+        bool isPathSupported = true;
+        result.addPath(pathTransforms.at(i).map(SvgPathParser::parse(paths.at(i), &isPathSupported)));
+        isSupported = isSupported && isPathSupported;
+    }
+
+    if (supported != nullptr)
+        *supported = isSupported;
+
+    return result;
+}
+
+bool SvgRestyler::strokeColor(QColor &color) const
+{
+    QRegularExpression declaration("(?<![\\w-])(stroke|fill|opacity|stroke-opacity|stroke-dasharray)\\s*:\\s*([^;}\\s]+)");
+    QRegularExpressionMatchIterator i = declaration.globalMatch(declarations.join(';'));
+    QStringList strokeValues;
+    bool isFillDisabled = false;
+
+    //the pen can't fill shapes or make them transparent
+    while (i.hasNext())
+    {
+        QRegularExpressionMatch match = i.next();
+        QString value = match.captured(2).toLower();
+
+        if (match.captured(1) == "stroke")
+            strokeValues << value;
+        else if (match.captured(1) == "fill")
+        {
+            if (value != "none")
+                return false;
+
+            isFillDisabled = true;
+        }
+        else if (value != "1" && value != "none")
+            return false;
+    }
+
+    strokeValues.removeDuplicates();
+
+    if (!isFillDisabled || strokeValues.size() != 1)
+        return false;
+
+    color = QColor(strokeValues.first());
+    return color.isValid();
+}
+
+bool SvgRestyler::lineStyle(Qt::PenCapStyle &cap, Qt::PenJoinStyle &join) const
+{
+    QRegularExpression declaration("(?<![\\w-])(stroke-linecap|stroke-linejoin)\\s*:\\s*([^;}\\s]+)");
+    QRegularExpressionMatchIterator i = declaration.globalMatch(declarations.join(';'));
+    QStringList capValues, joinValues;
+
+    while (i.hasNext())
+    {
+        QRegularExpressionMatch match = i.next();
+
+        if (match.captured(1) == "stroke-linecap")
+            capValues << match.captured(2).toLower();
+        else
+            joinValues << match.captured(2).toLower();
+    }
+
+    capValues.removeDuplicates();
+    joinValues.removeDuplicates();
+
+    if (capValues.size() > 1 || joinValues.size() > 1)
+        return false;
+
+    QString capValue = capValues.value(0, "butt");
+    QString joinValue = joinValues.value(0, "miter");
+
+    if (capValue == "butt")
+        cap = Qt::FlatCap;
+    else if (capValue == "round")
+        cap = Qt::RoundCap;
+    else if (capValue == "square")
+        cap = Qt::SquareCap;
+    else
+        return false;
+
+    if (joinValue == "miter")
+        join = Qt::SvgMiterJoin;
+    else if (joinValue == "round")
+        join = Qt::RoundJoin;
+    else if (joinValue == "bevel")
+        join = Qt::BevelJoin;
+    else
+        return false;
+
+    return true;
+}
+
+QString SvgRestyler::scaledViewBox(const QString &viewBox)
+{
+    QStringList viewBoxValues = viewBox.split(" ");
+
+    if (viewBoxValues.size() < 4)
+        return viewBox;
+
+    qreal width = viewBoxValues.at(2).toDouble() - viewBoxValues.at(0).toDouble();
+    qreal height = viewBoxValues.at(3).toDouble() - viewBoxValues.at(1).toDouble();
+
+    return QString("%1 %2 %3 %4")
+            .arg(static_cast<qreal>(viewBoxValues.at(0).toDouble() - width / 2))
+            .arg(static_cast<qreal>(viewBoxValues.at(1).toDouble() - height / 2))
+            .arg(static_cast<qreal>(viewBoxValues.at(2).toDouble() + width))
+            .arg(static_cast<qreal>(viewBoxValues.at(3).toDouble() + height));
+}
+
+void SvgRestyler::changeStyle(QString &style) const
+{
+    changeAttribute(style, "stroke-width", QString("%1").arg(penWidth));
+    if (penColor.isValid())
+        changeAttribute(style, "stroke", penColor.name(QColor::HexRgb));
+    if (isRoundLines)
+    {
+        changeAttribute(style, "stroke-linecap", "round");
+        changeAttribute(style, "stroke-linejoin", "round");
+    }
+}
+
+void SvgRestyler::collectDeclarations(const QXmlStreamAttributes &attributes)
+{
+    const QStringList properties = {"stroke", "fill", "opacity", "stroke-opacity", "stroke-dasharray",
+                                    "stroke-linecap", "stroke-linejoin"};
+
+    declarations << attributes.value("style").toString();
+
+    for (const QString &property : properties)
+        if (attributes.hasAttribute(property))
+            declarations << property + ':' + attributes.value(property).toString();
+}
+
+QRectF SvgRestyler::toRect(const QString &viewBox)
+{
+    QStringList viewBoxValues = viewBox.split(" ");
+
+    if (viewBoxValues.size() < 4)
+        return QRectF();
+
+    return QRectF(viewBoxValues.at(0).toDouble(), viewBoxValues.at(1).toDouble(),
+                  viewBoxValues.at(2).toDouble(), viewBoxValues.at(3).toDouble());
+}
+
+void SvgRestyler::setAttribute(QXmlStreamAttributes &attributes, const QString &name, const QString &value)
+{
+    for (QXmlStreamAttribute &attribute : attributes)
+        if (attribute.qualifiedName() == name)
+        {
+            attribute = QXmlStreamAttribute(name, value);
+            return;
+        }
+
+    attributes.append(name, value);
+}
+
+void SvgRestyler::changeAttribute(QString &attribute, QString parameter, QString newValue)
+{
+    if (attribute.contains(QRegularExpression(parameter + ":")))
+    {
+        int index = attribute.indexOf(parameter + ":");
+        int endSign = attribute.indexOf(QRegularExpression(";|}"), index);
+        int valueBegin = index + parameter.size() + 1;
+
+        attribute.remove(valueBegin, endSign - valueBegin);
+        attribute.insert(valueBegin, newValue);
+    }
+    else
+    {
+        int semicolon = attribute.lastIndexOf(QRegularExpression(";"));
+        int endSign = attribute.lastIndexOf(QRegularExpression(";|}"));
+        attribute.insert(semicolon > endSign ? semicolon : endSign,
+                         (attribute.isEmpty() ? "" : ";") + parameter + ":" + newValue);
+    }
+}
@@ -0,0 +1,75 @@
+/*!
+    SvgRestyler - rewrites an SVG image in a single pass of
+    QXmlStreamReader and QXmlStreamWriter, without building a document
+    tree and serializing it again.
+
+    The viewBox of the root element can be scaled, so strokes widened by
+    the pen aren't cut at the borders of the image. The pen replaces the
+    width, colour and line caps of strokes in the first "style" element
+    or, if the image has no "style" element before its paths, in "style"
+    attributes of the paths. Everything else is copied as it is.
+
+    On the way the restyler collects what callers used to look up in a
+    QDomDocument: the path data with transforms of the paths and their
+    parents, the viewBox and the declarations that tell the colour of
+    strokes. result() goes straight to QSvgRenderer or FontCache.
+*/
+#ifndef SVGRESTYLER_H
+#define SVGRESTYLER_H
+
+#include <QtCore/QByteArray>
+#include <QtCore/QStringList>
+#include <QtCore/QVector>
+#include <QtCore/QXmlStreamReader>
+#include <QtCore/QXmlStreamWriter>
+#include <QtGui/QColor>
+#include <QtGui/QPainterPath>
+#include <QtGui/QTransform>
+
+class SvgRestyler
+{
+public:
+    SvgRestyler();
+
+    void setViewBoxScaled(bool scale) {isViewBoxScaled = scale;} //!< twice as large around the centre
+    //! width is in units of the viewBox; an invalid colour and !roundLines keep these properties of the image
+    void setPen(qreal width, const QColor &color, bool roundLines);
+
+    bool restyle(const QByteArray &svg); //!< returns false if the image isn't well-formed XML
+
+    const QByteArray & result() const {return output;}
+    QRectF viewBox() const {return viewBoxRect;}             //!< of the result
+    QRectF sourceViewBox() const {return sourceViewBoxRect;} //!< of the image before scaling
+    bool hasIntrinsicSize() const {return isSizeSet;} //!< the root has width and height, so QSvgRenderer ignores the viewBox
+    const QStringList & pathData() const {return paths;} //!< "d" attributes of all paths in the order of the image
+    QString firstGroupTransform() const {return groupTransform;}
+    //! paths with their transforms applied; supported is false if the image has other shapes or arcs
+    QPainterPath path(bool *supported = nullptr) const;
+    bool strokeColor(QColor &color) const; //!< false if the image isn't strokes of one colour
+    //! caps and joins of strokes, SVG defaults if not declared; false if they differ or aren't known
+    bool lineStyle(Qt::PenCapStyle &cap, Qt::PenJoinStyle &join) const;
+
+    static QString scaledViewBox(const QString &viewBox);
+
+private:
+    bool isViewBoxScaled, hasPen, isRoundLines;
+    qreal penWidth;
+    QColor penColor;
+
+    QByteArray output;
+    QRectF viewBoxRect, sourceViewBoxRect;
+    bool isSizeSet;
+    QStringList paths;
+    QVector<QTransform> pathTransforms;
+    QString groupTransform;
+    bool hasOtherShapes;
+    QStringList declarations; //!< style sheets, "style" attributes and presentation attributes
+
+    void changeStyle(QString &style) const;
+    void collectDeclarations(const QXmlStreamAttributes &attributes);
+    static QRectF toRect(const QString &viewBox);
+    static void setAttribute(QXmlStreamAttributes &attributes, const QString &name, const QString &value);
+    static void changeAttribute(QString &attribute, QString parameter, QString newValue); //!< changes value of parameter in XML attribute
+};
+
+#endif // SVGRESTYLER_H
@@ -1,34 +1,67 @@
 /*!
     SvgView - class representing a sheet of paper with handwritten text.
 
-    It reads settings from a file, loads current font, changes it, places
-    letters on a sheet, connects letters within words and displays the result.
-    It also generates a QImage for MainWindow::save* functions.
+    It reads settings from a file, loads current font, changes it and
+    displays sheets laid out by its SheetLayout. It also generates
+    a QImage for MainWindow::save* functions.
 
-    An algorithm that places characters on a sheet is described in the function
-    renderText(). It takes the QStringRef with text, places as many characters
-    as possible on a single sheet and returns the number of the first character
-    that function has not processed.
+    renderText() takes the QStringRef with text, places as many characters
+    as possible on a single sheet, shows it and returns the number of
+    the first character that function has not processed.
 
-    preventGoingBeyondRightMargin() prevents going beyond right margin
-    by wrapping or hypphenating words, or just simply starts a new line.
+    The paper (marking and margins) isn't a part of the scene. It's
+    recorded by SheetLayout into a QPicture, which is drawn with borders
+    in drawBackground() and under the sheet in renderToImage().
+
+    If "glyph-atlas-export" is set, renderToImage() copies glyphs
+    from a GlyphAtlas rasterized at the output dpi instead of rendering
+    their SVG for every sheet. Rasterized glyphs are kept on disk in
+    a GlyphRasterCache limited by "glyph-cache-size" megabytes.
+
+    If "mipmap-navigation" is set, a raster copy of every rendered sheet
+    is made by MipmapBuilder, and zoom and pan draw it until the user
+    stops for a moment; then the sheet is painted as vectors again.
+
+    recordSheet() returns a SheetDisplayList of the rendered sheet.
+    It can be shown again by showSheet() or replayed by renderToImage()
+    and paintSheet() without laying the text out once more.
+    layOutText() records a sheet without showing it, so MainWindow can
+    prepare the neighbours of the shown sheet while the user reads it.
+    Sheets laid out by RenderWorker are shown after adoptSheet().
+
+    If "continuous-scroll" is set, all sheets are placed one under
+    another. Only the sheets near the viewport have SheetItems; the view
+    asks MainWindow for them by sheetsNeeded() and deletes them when
+    they are scrolled away, so the other sheets are just blank paper
+    of the known size.
+
+    setPaintStatisticsShown() switches an overlay with PaintStatistics
+    of the last frame: its time, painted and culled glyphs, timings of
+    glyphs, connections and the paper, and the zoom.
 */
 #ifndef SVGVIEW_H
 #define SVGVIEW_H
 
-#include <QtCore/QRegularExpression>
-#include <QtCore/QTextCodec>
 #include <QtCore/QSettings>
 #include <QtCore/QtMath>
+#include <QtCore/QBitArray>
+#include <QtCore/QTimer>
+#include <QtCore/QMap>
+#include <QtCore/QElapsedTimer>
 #include <QtWidgets/QGraphicsView>
 #include <QtWidgets/QGraphicsColorizeEffect>
+#include <QtWidgets/QScrollBar>
 #include <QtWidgets/QApplication>
 #include <QtGui/QWheelEvent>
-#include <QtSvg/QGraphicsSvgItem>
-#include <QtSvg/QSvgRenderer>
-#include <QtXml/QDomDocument>
 
-#include "symboldata.h"
+#include "sheetlayout.h"
+#include "sheetitem.h"
+#include "sheetdisplaylist.h"
+#include "glyphatlas.h"
+#include "glyphrastercache.h"
+#include "mipmapbuilder.h"
+#include "missingglyphs.h"
+#include "renderstatistics.h"
 
 class SvgView : public QGraphicsView
 {
@@ -38,79 +71,74 @@ public:
     explicit SvgView(QWidget *parent = 0);
     ~SvgView();
 
-    static void scaleViewBox(QDomElement &svgElement);
+    bool isContinuous() const {return continuous;}
+    int sheetCount() const {return sheetPlaces;}
 
 public slots:
     int renderText(const QStringRef &text = QStringRef());
-    QImage saveRenderToImage();
+    SheetDisplayList recordSheet() const {return sheetItem->displayList();}
+    int layOutText(const QStringRef &text, bool changedMargins, SheetDisplayList &sheet); //!< like renderText(), but the shown sheet stays intact
+    void adoptSheet(SheetDisplayList &sheet) {layout.adopt(sheet);} //!< makes a sheet of RenderWorker drawable here
+    void releaseGlyphPack(const QString &fileName) {layout.releaseGlyphPack(fileName);}
+    void showSheet(const SheetDisplayList &sheet);
+    QImage renderToImage(const SheetDisplayList &sheet); //!< the sheet without borders at the dpi of settings
+    void paintSheet(QPainter *painter, const SheetDisplayList &sheet, int resolution); //!< vectors for PDF and printers
     void loadFont(QString fontpath = QString());
     void loadSettingsFromFile();
+    void previewPen(qreal width, const QColor &color, bool useCustomColor, bool roundLines); //!< shown sheets are redrawn with the pen
     void hideBorders(bool hide);
     void changeLeftRightMargins(bool change);
-    QList<QChar> getFontKeys() {return font.uniqueKeys();}
+    QList<QChar> getFontKeys() {return layout.getFontKeys();}
+    const QBitArray & getFontCoverage() const {return layout.getFontCoverage();}
+    const MissingGlyphs & getMissingGlyphs() const {return sheetItem->displayList().missingGlyphs;} //!< missing characters of the shown sheet
+    const RenderStatistics & getRenderStatistics() const {return layout.getRenderStatistics();}
+    void setSheetCount(int count); //!< continuous mode: number of places for sheets
+    void setSheet(int number, const SheetDisplayList &sheet); //!< continuous mode: ignored far from the viewport
+    void clearSheets(int first = 0); //!< continuous mode: turns sheets from first to blank paper
+    void scrollToSheet(int number);
+    void updateVisibleSheets();
+    void setPaintStatisticsShown(bool show);
+
+signals:
+    void sheetsNeeded(int first, int last); //!< some of these sheets are blank
+    void currentSheetChanged(int number);   //!< the sheet in the middle of the viewport
+    void fontLoadProgress(int loaded, int total); //!< glyphs compiled by loadFont()
 
 protected:
     void wheelEvent(QWheelEvent *event);
+    void resizeEvent(QResizeEvent *event);
+    void paintEvent(QPaintEvent *event);
+    void scrollContentsBy(int dx, int dy);
+    void drawBackground(QPainter *painter, const QRectF &rect);
 
-private:
-    struct SvgData
-    {
-        SymbolData symbolData;
-        qreal scale;
-        QSvgRenderer *renderer;
-    };
+private slots:
+    void endInteraction();
 
+private:
     QGraphicsScene *scene;
-    QMultiMap<QChar, SvgData> font;
-    QVector<QVector<QGraphicsSvgItem *>> storedWordItems; //!< there stored items that forming words
-    QVector<QVector<SymbolData>> storedSymbolData; //!< data for items in storedWordItems
-    int dpi;  //!< dots per inch
-    int dpmm; //!< dots per millimeter
-    int spacesInTab;
-    int seed;
-    uint itemsToRemove;
-    bool useCustomFontColor, changeMargins, hideMarginsRect, connectingLetters,
-         useSeed, roundLines, wordWrap, hyphenateWords, areBordersHidden,
-         leftMarginRandomEnabled, symbolJumpRandomEnabled, letterSpacingRandomEnabled,
-         markingEnabled, isMarkingLines, drawLeftMargins, drawRightMargins;
+    SheetItem *sheetItem;  //!< holds all symbols of the current sheet
+    QMap<int, SheetItem *> sheetItems; //!< continuous mode: sheets near the viewport
+    int sheetPlaces, centralSheet;
+    SheetLayout layout;
+    MipmapBuilder *mipmapBuilder;
+    QTimer *interactionTimer; //!< detects the end of zoom or pan
+    GlyphRasterCache glyphRasterCache; //!< glyphs rasterized in previous runs
+    GlyphAtlas glyphAtlas; //!< rasterized glyphs of the font for image export
+    bool changeMargins, hideMarginsRect, areBordersHidden, useGlyphAtlas, useMipmaps, continuous;
+    PaintStatistics paintStatistics; //!< of the last frame
+    bool isPaintStatisticsShown;
+    QElapsedTimer frameClock;
+    qreal frameInterval; //!< milliseconds between frames, smoothed
     qreal maxScaleFactor = 1.5; //NOTE: If this is exceeded, graphic artifacts will occure
     qreal minScaleFactor = 0.05, currentScaleFactor = 1.0;
-    qreal fontSize, penWidth, letterSpacing, lineSpacing, wordSpacing,
-          leftMarginRandomValue, symbolJumpRandomValue, letterSpacingRandomValue,
-          markingCheckSize, markingLineSize, markingPenWidth, leftMarginsIndent, rightMarginsIndent;
-    QRectF sheetRect, marginsRect;
-    QColor fontColor, markingColor, marginsColor;
-    QVector<QRegularExpression> hyphenRules;
-
-    SymbolData symbolData, previousSymbolData;
-    QRectF currentMarginsRect;
-    qreal currentLetterSpacing;
-    QSizeF symbolBoundingSize;
-    QPointF cursor; /*!< cursor is pointing to where will be placed
-                         the top left corner of the next character limits */
-    QPointF previousSymbolCursor;
-    qreal previousSymbolWidth;
 
     void limitScale(qreal factor);  //!< limited view zoom
-    void prepareSceneToRender();
-    bool preventGoingBeyondRightMargin(qreal letterWidth, QStringRef text, int currentSymbolIndex);
-    void connectLetters();
-    void processUnknownSymbol(const QChar &symbol);
-    void insertSymbol(QChar key, SymbolData &symbolData);
-    void changeAttribute(QString &attribute, QString parameter, QString newValue); //!< changes value of parameter in XML attribute
-    bool wrapWords(QStringRef text, int currentSymbolIndex);
-    bool wrapLastSymbols(int symbolsToWrap);
-    void removeLastSymbols();
-    bool hyphenate(QStringRef text, int currentSymbolIndex);
-    void loadHyphenRules();
-    QRectF changedVerticalMargins();
-    QGraphicsSvgItem * generateHyphen(int symbolsToWrap);
-    void randomizeMargins();
-    void randomizeLetterSpacing();
-    QPointF symbolPositionRandomValue();
-    void cursorToNewLine();
-    void drawMarking();
-    void drawMargins();
+    void beginInteraction();
+    void drawPaper(QPainter *painter, const SheetDisplayList &sheet); //!< draws the paper of a sheet and borders
+    qreal sheetStep() const; //!< distance between tops of sheets in continuous mode
+    void visibleSheets(int &first, int &last) const; //!< with a neighbour above and below
+    void releaseSheet(int number);
+    void drawPaintStatistics();
 };
 
 #endif // SVGVIEW_H
@@ -31,29 +31,31 @@ void SymbolDataEditor::loadSettings()
 
 void SymbolDataEditor::load(const QString & fileName)
 {
-    loadSettings();
-
-    doc = QDomDocument("SVG");
     QFile file(fileName);
 
     if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
         return;
 
-    if (!doc.setContent(&file))
-    {
-        file.close();
-        return;
-    }
+    loadData(file.readAll());
+}
 
-    file.close();
+void SymbolDataEditor::loadData(const QByteArray &svg)
+{
+    loadSettings();
 
-    //scale viewbox because it is necessary in SvgView::insertSymbol()
-    QDomElement svgElement = doc.elementsByTagName("svg").item(0).toElement();
-    SvgView::scaleViewBox(svgElement);
-    QByteArray scaledFile = doc.toString(0).replace(">\n<tspan", "><tspan").toUtf8();
+    //scale viewbox because it is necessary in SheetLayout::prepareSymbol()
+    SvgRestyler restyler;
+    restyler.setViewBoxScaled(true);
+
+    if (!restyler.restyle(svg))
+        return;
+
+    viewBox = restyler.viewBox();
+    pathData = restyler.pathData();
+    groupTransform = restyler.firstGroupTransform();
 
     QGraphicsSvgItem *symbolItem = new QGraphicsSvgItem();
-    symbolItem->setSharedRenderer(new QSvgRenderer(scaledFile));
+    symbolItem->setSharedRenderer(new QSvgRenderer(restyler.result()));
 
     QSizeF itemSize = symbolItem->renderer()->defaultSize();
     clear();
@@ -144,7 +146,7 @@ QPointF SymbolDataEditor::toStored(const QPointF &point) const
     QPointF result = point - symbolRect.topLeft();
     result.rx() = point.x() / symbolRect.width();
     result.ry() = point.y() / symbolRect.height();
-    result -= QPointF(2.0,2.0); //WARNING: I don't know why this works, but it depends on SvgView::scaleViewBox()
+    result -= QPointF(2.0,2.0); //WARNING: I don't know why this works, but it depends on SvgRestyler::scaledViewBox()
     return result;
 }
 
@@ -162,12 +164,6 @@ QPointF SymbolDataEditor::fromStored(const QPointF &point) const
 QPointF SymbolDataEditor::fromViewBox(const QPointF &point) const
 {
     QPointF result = point;
-    QDomElement svgElement = doc.elementsByTagName("svg").item(0).toElement();
-    QStringList viewBoxValues = svgElement.attribute("viewBox").split(" ");
-
-    QRectF viewBox = QRectF(viewBoxValues.at(0).toDouble(), viewBoxValues.at(1).toDouble(),
-                            viewBoxValues.at(2).toDouble(), viewBoxValues.at(3).toDouble());
-
     result -= viewBox.topLeft();
     result.rx() /= viewBox.width();
     result.ry() /= viewBox.height();
@@ -530,8 +526,7 @@ QPointF SymbolDataEditor::getEndPoint()
 
 QPointF SymbolDataEditor::getTranslatePoint()
 {
-    QDomElement gElement = doc.elementsByTagName("g").item(0).toElement();
-    QString transform = gElement.attribute("transform");
+    QString transform = groupTransform;
 
     if (transform.contains("translate"))
     {
@@ -570,13 +565,7 @@ QPointF SymbolDataEditor::getMovePoint(const QString &path)
 
 QStringList SymbolDataEditor::getPathList()
 {
-    QDomNodeList pathDomNodeList = doc.elementsByTagName("path");
-    QStringList pathStringList;
-
-    for (int i = 0; i < pathDomNodeList.size(); i++)
-        pathStringList.append(pathDomNodeList.at(i).toElement().attribute("d"));
-
-    return pathStringList;
+    return pathData;
 }
 
  QPointF SymbolDataEditor::getLastCurvePoint(const QString &path)
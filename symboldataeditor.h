@@ -22,14 +22,18 @@
 #ifndef SVGDATAEDITOR_H
 #define SVGDATAEDITOR_H
 
+#include <QtCore/QFile>
+#include <QtCore/QRegularExpression>
+#include <QtCore/QSettings>
 #include <QtCore/QtMath>
 #include <QtWidgets/QGraphicsView>
 #include <QtWidgets/QGraphicsItem>
+#include <QtWidgets/QApplication>
 #include <QtSvg/QGraphicsSvgItem>
 #include <QtSvg/QSvgRenderer>
 #include <QtGui/QWheelEvent>
 
-#include "svgview.h"
+#include "svgrestyler.h"
 
 class SymbolDataEditor : public QGraphicsView
 {
@@ -40,6 +44,7 @@ public:
     ~SymbolDataEditor();
 
     void load(const QString & fileName); //!< loads specified item
+    void loadData(const QByteArray &svg); //!< loads an item from the image in memory, e.g. from a glyph pack
     void setSymbolData(const QPointF _inPoint, const QPointF _outPoint, const QRectF _limits);
     void clear();
     void disableChanges();
@@ -88,7 +93,9 @@ private:
     bool setupPoints, pointsEnabled;
     QPointF inPoint, outPoint, dLimitsCenter;
     QRectF limits;
-    QDomDocument doc;
+    QRectF viewBox;          //!< of the scaled image, see SvgRestyler
+    QStringList pathData;    //!< "d" attributes of paths of the image
+    QString groupTransform;  //!< "transform" attribute of the first group of the image
 
     void limitScale(qreal factor);  //!< limited view zoom
     void loadSettings();
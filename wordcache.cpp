@@ -0,0 +1,51 @@
+#include "wordcache.h"
+
+WordCache::WordCache(int variantsPerWord)
+{
+    variants = qMax(1, variantsPerWord);
+    hitCount = 0;
+    missCount = 0;
+    cache.setMaxCost(0);
+}
+
+QSharedPointer<WordVariant> WordCache::find(const QString &word, int variant)
+{
+    QSharedPointer<WordVariant> *data = cache.object(Key(word, variant));
+
+    if (data == nullptr)
+    {
+        missCount++;
+        return QSharedPointer<WordVariant>();
+    }
+
+    hitCount++;
+    return *data;
+}
+
+void WordCache::insert(const QString &word, int variant, const QSharedPointer<WordVariant> &data)
+{
+    if (!isEnabled() || data.isNull())
+        return;
+
+    int cost = qMax(1, data->image.byteCount() / 1024);
+    cache.insert(Key(word, variant), new QSharedPointer<WordVariant>(data), cost);
+}
+
+void WordCache::clear()
+{
+    cache.clear();
+    hitCount = 0;
+    missCount = 0;
+}
+
+void WordCache::setMaxSize(qint64 bytes)
+{
+    cache.setMaxCost(int(qBound(Q_INT64_C(0), bytes / 1024, Q_INT64_C(0x7fffffff))));
+}
+
+qreal WordCache::hitRate() const
+{
+    int total = hitCount + missCount;
+
+    return total > 0 ? qreal(hitCount) / total : 0.0;
+}
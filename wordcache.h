@@ -0,0 +1,66 @@
+/*!
+    WordCache - words laid out and rasterized once and reused on sheets.
+
+    Every cached word has up to K variants. A variant is built with its
+    own random generator seeded by the word, the variant number and the
+    seed of settings, so a word looks the same no matter whether it's
+    taken from the cache or built again; SheetLayout chooses the variant
+    with the seeded qrand(), so sheets stay varied and reproducible.
+
+    The advance of a variant is known before it's placed, so the layout
+    can put the whole word at once. Its image (glyphs and connections
+    at the output dpi) is copied to exported sheets instead of rendering
+    every glyph.
+
+    The cache is limited by the size of images; least recently used
+    words are dropped first.
+*/
+#ifndef WORDCACHE_H
+#define WORDCACHE_H
+
+#include <QtCore/QCache>
+#include <QtCore/QPair>
+#include <QtCore/QString>
+#include <QtGui/QImage>
+
+#include "sheetdisplaylist.h"
+
+struct WordVariant
+{
+    QVector<PlacedGlyph> glyphs; //!< positions are relative to the cursor at the beginning of the word
+    QPainterPath connections;    //!< connections of the letters, relative to the cursor too
+    qreal width;     //!< from the cursor to the right limit of the last letter
+    qreal advance;   //!< from the cursor to the cursor after the word
+    QPointF lastCursor; //!< cursor of the last letter, relative
+    qreal lastWidth;    //!< width of the last letter
+    QImage image;       //!< glyphs and connections at the output dpi
+    QPoint imageOffset; //!< top left corner of the image relative to the cursor
+};
+
+class WordCache
+{
+public:
+    explicit WordCache(int variantsPerWord = 4);
+
+    QSharedPointer<WordVariant> find(const QString &word, int variant);
+    void insert(const QString &word, int variant, const QSharedPointer<WordVariant> &data);
+    void clear();
+
+    void setMaxSize(qint64 bytes); //!< 0 disables the cache
+    bool isEnabled() const {return cache.maxCost() > 0;}
+    void setVariantsPerWord(int count) {variants = qMax(1, count);}
+    int variantsPerWord() const {return variants;}
+
+    int hits() const {return hitCount;}
+    int misses() const {return missCount;}
+    qreal hitRate() const;
+
+private:
+    typedef QPair<QString, int> Key;
+
+    QCache<Key, QSharedPointer<WordVariant>> cache; //!< costs are sizes of images in kilobytes
+    int variants;
+    int hitCount, missCount;
+};
+
+#endif // WORDCACHE_H